@@ -0,0 +1,133 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+#define ARENA_ALIGN sizeof(void*)
+
+void initArena(Arena* arena) {
+    memset(arena, 0, sizeof(Arena));
+}
+
+/* Lop cua size neu size la luy thua 2 co the tai su dung, nguoc lai -1 */
+static int sizeClass(size_t size) {
+    if (size < ARENA_ALIGN || (size & (size - 1)) != 0) {
+        return -1;
+    }
+    int cls = 0;
+    while (((size_t)1 << cls) < size) cls++;
+    return cls < ARENA_SIZE_CLASSES ? cls : -1;
+}
+
+static ArenaBlock* newBlock(Arena* arena, size_t size) {
+    ArenaBlock* block = (ArenaBlock*)malloc(sizeof(ArenaBlock) + size);
+    if (!block) {
+        perror("Loi cap phat bo nho cho arena");
+        exit(1);
+    }
+    block->size = size;
+    block->used = 0;
+    arena->blockCount++;
+    arena->bytesReserved += size;
+    return block;
+}
+
+static unsigned char* blockData(ArenaBlock* block) {
+    return (unsigned char*)(block + 1);
+}
+
+/* Cap phat size byte, canh le align (1 hoac ARENA_ALIGN) */
+static void* bumpAlloc(Arena* arena, size_t size, size_t align) {
+    arena->allocCount++;
+
+    if (size > ARENA_BLOCK_SIZE / 4) {
+        /* Khoi rieng, dat sau khoi dang cap phat de khong bo phi phan con lai cua no */
+        ArenaBlock* block = newBlock(arena, size);
+        block->used = size;
+        if (arena->blocks) {
+            block->next = arena->blocks->next;
+            arena->blocks->next = block;
+        } else {
+            block->next = NULL;
+            arena->blocks = block;
+        }
+        return blockData(block);
+    }
+
+    ArenaBlock* block = arena->blocks;
+    size_t offset = block ? (block->used + align - 1) & ~(align - 1) : 0;
+    if (!block || offset + size > block->size) {
+        block = newBlock(arena, ARENA_BLOCK_SIZE);
+        block->next = arena->blocks;
+        arena->blocks = block;
+        offset = 0;
+    }
+    block->used = offset + size;
+    return blockData(block) + offset;
+}
+
+void* arenaAlloc(Arena* arena, size_t size) {
+    int cls = sizeClass(size);
+    if (cls >= 0 && arena->freeLists[cls]) {
+        void* p = arena->freeLists[cls];
+        arena->freeLists[cls] = *(void**)p;
+        arena->allocCount++;
+        arena->reuseCount++;
+        return p;
+    }
+    return bumpAlloc(arena, size, ARENA_ALIGN);
+}
+
+void arenaRelease(Arena* arena, void* ptr, size_t size) {
+    int cls = sizeClass(size);
+    if (ptr && cls >= 0) {
+        *(void**)ptr = arena->freeLists[cls];
+        arena->freeLists[cls] = ptr;
+    }
+}
+
+void* arenaRealloc(Arena* arena, void* ptr, size_t oldSize, size_t newSize) {
+    void* p = arenaAlloc(arena, newSize);
+    if (ptr) {
+        memcpy(p, ptr, oldSize < newSize ? oldSize : newSize);
+        arenaRelease(arena, ptr, oldSize);
+    }
+    return p;
+}
+
+char* arenaStrdup(Arena* arena, const char* text) {
+    size_t len = strlen(text) + 1;
+    char* copy = (char*)bumpAlloc(arena, len, 1);
+    memcpy(copy, text, len);
+    return copy;
+}
+
+/* Chuyen toan bo khoi cua other sang arena; other tro lai rong. Danh sach o trong cua other bi bo */
+void arenaAdopt(Arena* arena, Arena* other) {
+    if (other->blocks) {
+        if (arena->blocks) {
+            ArenaBlock* last = other->blocks;
+            while (last->next) last = last->next;
+            last->next = arena->blocks->next;
+            arena->blocks->next = other->blocks;
+        } else {
+            arena->blocks = other->blocks;
+        }
+    }
+    arena->allocCount += other->allocCount;
+    arena->reuseCount += other->reuseCount;
+    arena->blockCount += other->blockCount;
+    arena->bytesReserved += other->bytesReserved;
+    initArena(other);
+}
+
+void freeArena(Arena* arena) {
+    ArenaBlock* block = arena->blocks;
+    while (block) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    initArena(arena);
+}
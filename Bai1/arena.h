@@ -0,0 +1,40 @@
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <stddef.h>
+
+/* Kich thuoc mot khoi thuong; yeu cau lon hon ARENA_BLOCK_SIZE / 4 duoc cap khoi rieng */
+#define ARENA_BLOCK_SIZE (1 << 20)
+/* Lop kich thuoc luy thua 2 (8 .. 2^31 byte) co danh sach o trong de tai su dung */
+#define ARENA_SIZE_CLASSES 32
+
+typedef struct ArenaBlock_ {
+    struct ArenaBlock_* next;
+    size_t size;
+    size_t used;
+} ArenaBlock;
+
+/*
+ * Bo cap phat theo kieu don con tro: cap phat trong khoi lon, giai phong ca arena mot lan.
+ * Vung nho luy thua 2 tra lai bang arenaRelease duoc dung lai cho lan cap phat cung kich thuoc.
+ * Khong an toan giua cac luong: moi luong dung arena rieng roi gop bang arenaAdopt.
+ */
+typedef struct {
+    ArenaBlock* blocks;                     /* khoi dau danh sach la khoi dang cap phat */
+    void* freeLists[ARENA_SIZE_CLASSES];
+
+    size_t allocCount;                      /* so lan cap phat */
+    size_t reuseCount;                      /* so lan lay tu danh sach o trong */
+    size_t blockCount;                      /* so lan goi malloc */
+    size_t bytesReserved;
+} Arena;
+
+void initArena(Arena* arena);
+void* arenaAlloc(Arena* arena, size_t size);
+void* arenaRealloc(Arena* arena, void* ptr, size_t oldSize, size_t newSize);
+void arenaRelease(Arena* arena, void* ptr, size_t size);
+char* arenaStrdup(Arena* arena, const char* text);
+void arenaAdopt(Arena* arena, Arena* other);
+void freeArena(Arena* arena);
+
+#endif
@@ -0,0 +1,384 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "indexer.h"
+#include "unicode.h"
+
+/*
+ * Do hieu nang bo lap chi muc tren kho tong hop: tu vung co tan suat theo luat Zipf
+ * (tu hang r xuat hien ti le voi 1 / r^s), cac tu dung chiem nhung hang dau.
+ * Moi giai doan chay rieng tren ket qua cua giai doan truoc:
+ *
+ *   tach tu -> loc tu dung -> chen -> sap xep -> ghi ket qua
+ *
+ * va "toan bo" chay duong ong gop nhu l1 de so sanh voi tong cac giai doan. Cot RSS la phan
+ * RSS hien tai tang them trong giai doan (RSS dinh chi tang nen khong tach duoc theo giai doan),
+ * vi vay duong ong gop chay sau cung, khi cac giai doan rieng da giai phong bo nho cua minh.
+ */
+
+#define DEFAULT_CORPUS_MB 64
+#define DEFAULT_VOCABULARY 50000
+#define MIN_GEN_WORD_LEN 3
+#define MAX_GEN_WORD_LEN 10
+#define SENTENCE_ODDS 12        /* trung binh cu 12 tu co mot dau cham */
+#define PROPER_ODDS 50          /* 1/50 so tu giua cau viet hoa */
+
+/* -U: mot nua so tu ngau nhien co them mot nguyen am tieng Viet co dau (2-3 byte UTF-8) */
+static const char* g_vietnameseVowels[] = {
+    "\xc4\x83", "\xc3\xa2", "\xc3\xaa", "\xc3\xb4", "\xc6\xa1", "\xc6\xb0", "\xc4\x91",   /* ă â ê ô ơ ư đ */
+    "\xc3\xa1", "\xc3\xa0", "\xe1\xba\xa3", "\xc3\xa3", "\xe1\xba\xa1",                  /* á à ả ã ạ */
+    "\xe1\xba\xbf", "\xe1\xbb\x81", "\xe1\xbb\x87", "\xe1\xbb\x91", "\xe1\xbb\x9b",   /* ế ề ệ ố ớ */
+    "\xe1\xbb\xa9", "\xe1\xbb\xb1", "\xc3\xad", "\xc3\xba", "\xc3\xbd"                   /* ứ ự í ú ý */
+};
+
+typedef struct {
+    char** words;
+    unsigned char* lengths;
+    double* cumulative;         /* ham phan phoi tich luy, cumulative[n - 1] = 1 */
+    int count;
+} Vocabulary;
+
+typedef struct {
+    struct timespec start;
+    double seconds;
+    double rssStart;            /* MB, -1 neu khong doc duoc RSS */
+    double rssGrowth;           /* RSS cuoi tru RSS dau giai doan, co the am */
+} StageTimer;
+
+uint64_t g_rngState = 0x9E3779B97F4A7C15ull;
+
+uint64_t nextRandom(void) {
+    /* xorshift64* */
+    g_rngState ^= g_rngState >> 12;
+    g_rngState ^= g_rngState << 25;
+    g_rngState ^= g_rngState >> 27;
+    return g_rngState * 0x2545F4914F6CDD1Dull;
+}
+
+double randomUnit(void) {
+    return (nextRandom() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+void buildVocabulary(Vocabulary* vocab, int count, double exponent) {
+    vocab->count = count;
+    vocab->words = (char**)malloc(count * sizeof(char*));
+    vocab->lengths = (unsigned char*)malloc(count);
+    vocab->cumulative = (double*)malloc(count * sizeof(double));
+    if (!vocab->words || !vocab->lengths || !vocab->cumulative) {
+        perror("Loi cap phat tu vung");
+        exit(1);
+    }
+
+    /* Tu dung o cac hang dau, phan con lai la chuoi chu cai ngau nhien */
+    int rank = 0;
+    for (unsigned int i = 0; g_stopWords && i <= g_stopWordsMask && rank < count; i++) {
+        if (g_stopWords[i].word) {
+            vocab->words[rank++] = strdup(g_stopWords[i].word);
+        }
+    }
+    for (; rank < count; rank++) {
+        int length = MIN_GEN_WORD_LEN + (int)(nextRandom() % (MAX_GEN_WORD_LEN - MIN_GEN_WORD_LEN + 1));
+        char* word = (char*)malloc(length + 4);
+        if (!word) {
+            perror("Loi cap phat tu vung");
+            exit(1);
+        }
+        for (int j = 0; j < length; j++) {
+            word[j] = (char)('a' + nextRandom() % 26);
+        }
+        if (g_utf8Mode && nextRandom() % 2) {
+            /* Giu chu dau la ASCII de viet hoa dau cau bang mot phep tru */
+            const char* vowel = g_vietnameseVowels[nextRandom() % (sizeof(g_vietnameseVowels) / sizeof(g_vietnameseVowels[0]))];
+            int at = 1 + (int)(nextRandom() % (length - 1));
+            size_t n = strlen(vowel);
+            memmove(word + at + n, word + at, length - at);
+            memcpy(word + at, vowel, n);
+            length += (int)n;
+        }
+        word[length] = '\0';
+        vocab->words[rank] = word;
+    }
+
+    double total = 0;
+    for (int i = 0; i < count; i++) {
+        vocab->lengths[i] = (unsigned char)strlen(vocab->words[i]);
+        total += 1.0 / pow(i + 1, exponent);
+        vocab->cumulative[i] = total;
+    }
+    for (int i = 0; i < count; i++) {
+        vocab->cumulative[i] /= total;
+    }
+}
+
+int sampleWord(const Vocabulary* vocab) {
+    double u = randomUnit();
+    int lo = 0, hi = vocab->count - 1;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (vocab->cumulative[mid] < u) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+void freeVocabulary(Vocabulary* vocab) {
+    for (int i = 0; i < vocab->count; i++) {
+        free(vocab->words[i]);
+    }
+    free(vocab->words);
+    free(vocab->lengths);
+    free(vocab->cumulative);
+}
+
+/* Sinh it nhat size byte van ban, dong 60-80 ky tu, cau ket thuc bang '.' va bat dau bang chu hoa */
+unsigned char* generateCorpus(const Vocabulary* vocab, size_t size, size_t* outSize, long* outWords) {
+    size_t capacity = size + 2 * (MAX_WORD_LEN + 2);
+    unsigned char* buf = (unsigned char*)malloc(capacity);
+    if (!buf) {
+        perror("Loi cap phat kho tong hop");
+        exit(1);
+    }
+
+    size_t used = 0;
+    size_t lineStart = 0;
+    size_t lineLimit = 60 + nextRandom() % 21;
+    int sentenceStart = 1;
+    long words = 0;
+
+    while (used < size) {
+        int w = sampleWord(vocab);
+        const char* word = vocab->words[w];
+        int length = vocab->lengths[w];
+
+        if (used > lineStart && used - lineStart + length + 1 > lineLimit) {
+            buf[used++] = '\n';
+            lineStart = used;
+            lineLimit = 60 + nextRandom() % 21;
+        } else if (used > lineStart) {
+            buf[used++] = ' ';
+        }
+
+        memcpy(buf + used, word, length);
+        if (sentenceStart || nextRandom() % PROPER_ODDS == 0) {
+            buf[used] = (unsigned char)(buf[used] - 'a' + 'A');
+        }
+        used += length;
+        words++;
+
+        sentenceStart = nextRandom() % SENTENCE_ODDS == 0;
+        if (sentenceStart) {
+            buf[used++] = '.';
+        }
+    }
+    buf[used++] = '\n';
+
+    *outSize = used;
+    *outWords = words;
+    return buf;
+}
+
+/* RSS hien tai cua tien trinh theo /proc/self/statm, -1 neu khong biet */
+double currentRssMB(void) {
+#ifndef _WIN32
+    FILE* file = fopen("/proc/self/statm", "r");
+    if (file) {
+        long pages, resident;
+        int ok = fscanf(file, "%ld %ld", &pages, &resident) == 2;
+        fclose(file);
+        long pageSize = sysconf(_SC_PAGESIZE);
+        if (ok && pageSize > 0) {
+            return resident * (double)pageSize / (1024.0 * 1024.0);
+        }
+    }
+#endif
+    return -1;
+}
+
+void startStage(StageTimer* timer) {
+    timer->rssStart = currentRssMB();
+    clock_gettime(CLOCK_MONOTONIC, &timer->start);
+}
+
+void endStage(StageTimer* timer) {
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    timer->seconds = (end.tv_sec - timer->start.tv_sec) + (end.tv_nsec - timer->start.tv_nsec) / 1e9;
+    double rssEnd = currentRssMB();
+    if (rssEnd < 0) {
+        timer->rssStart = -1;
+    }
+    timer->rssGrowth = rssEnd - timer->rssStart;
+}
+
+/* items: so tu (tach tu, loc, chen) hoac so tu phan biet (sap xep, ghi ket qua) ma giai doan da xu ly */
+void reportStage(const char* name, const StageTimer* timer, size_t bytes, long items) {
+    double seconds = timer->seconds > 0 ? timer->seconds : 1e-9;
+    printf("%-14s %10.3f %10.1f %14.0f %10ld ", name, timer->seconds,
+           bytes / (1024.0 * 1024.0) / seconds, items / seconds, items);
+    if (timer->rssStart >= 0) {
+        printf("%+10.1f\n", timer->rssGrowth);
+    } else {
+        printf("%10s\n", "-");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    double sizeMB = DEFAULT_CORPUS_MB;
+    int vocabularySize = DEFAULT_VOCABULARY;
+    double exponent = 1.0;
+    int jobs = 1;
+    const char* stopWordFile = "stopw.txt";
+    const char* corpusFile = NULL;
+    const char* outputFile = "l1bench.out";
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            sizeMB = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-v") == 0 && i + 1 < argc) {
+            vocabularySize = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-z") == 0 && i + 1 < argc) {
+            exponent = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            jobs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            g_rngState = strtoull(argv[++i], NULL, 10) | 1;
+        } else if (strcmp(argv[i], "-S") == 0 && i + 1 < argc) {
+            stopWordFile = argv[++i];
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            corpusFile = argv[++i];
+        } else if (strcmp(argv[i], "-U") == 0) {
+            g_utf8Mode = 1;
+        } else {
+            fprintf(stderr, "Cach dung: %s [-s MB] [-v so_tu] [-z mu_Zipf] [-j N] [-r hat_giong] [-S tep_tu_dung] [-o tep_kho] [-U]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (sizeMB <= 0 || vocabularySize < 1 || exponent < 0 || jobs < 1) {
+        fprintf(stderr, "Loi: Tham so khong hop le\n");
+        return 1;
+    }
+
+    initCharClasses();
+    if (g_utf8Mode) {
+        initUnicodeTables();
+    }
+    loadStopWords(stopWordFile);
+    addDocument("kho_tong_hop");
+
+    StageTimer timer, fused;
+    Vocabulary vocab;
+    size_t size;
+    long generated;
+
+    startStage(&timer);
+    buildVocabulary(&vocab, vocabularySize, exponent);
+    unsigned char* corpus = generateCorpus(&vocab, (size_t)(sizeMB * 1024 * 1024), &size, &generated);
+    endStage(&timer);
+
+    if (corpusFile) {
+        FILE* file = fopen(corpusFile, "wb");
+        if (!file) {
+            fprintf(stderr, "Loi: Khong the mo tep %s\n", corpusFile);
+        } else {
+            fwrite(corpus, 1, size, file);
+            fclose(file);
+        }
+    }
+
+    printf("Kho tong hop: %.1f MB, %ld tu, tu vung %d, Zipf s=%.2f, %d luong sap xep%s\n",
+           size / (1024.0 * 1024.0), generated, vocabularySize, exponent, jobs, g_utf8Mode ? ", UTF-8" : "");
+    printf("%-14s %10s %10s %14s %10s %10s\n", "giai doan", "giay", "MB/s", "tu/s", "so tu", "RSS tang");
+    reportStage("sinh kho", &timer, size, generated);
+
+    /* Tach tu: chi ghi lai tu, dong va co danh tu rieng */
+    IndexTable table;
+    Tokenizer tok;
+    TokenList list;
+    initTokenList(&list);
+    initTokenizer(&tok);
+    tok.tokens = &list;
+    startStage(&timer);
+    tokenizeBlock(&tok, corpus, size, NULL);
+    finishTokenizer(&tok, NULL);
+    endStage(&timer);
+    reportStage("tach tu", &timer, size, list.count);
+
+    /* Loc: bo danh tu rieng va tu dung, don cac tu con lai len dau danh sach */
+    int tokenCount = list.count;
+    int kept = 0;
+    startStage(&timer);
+    for (int i = 0; i < tokenCount; i++) {
+        const Token* token = &list.tokens[i];
+        if (!token->proper && !isStopWord(list.text + token->offset, token->length)) {
+            list.tokens[kept++] = *token;
+        }
+    }
+    endStage(&timer);
+    reportStage("loc tu dung", &timer, size, tokenCount);
+
+    initIndexTable(&table);
+    startStage(&timer);
+    for (int i = 0; i < kept; i++) {
+        const Token* token = &list.tokens[i];
+        const char* word = list.text + token->offset;
+        IndexEntry* entry = findWord(&table, word);
+        if (entry == NULL) {
+            entry = addWord(&table, word);
+        }
+        entry->count++;
+        addLinePosting(&table.arena, entry, 0, token->lineNumber);
+    }
+    endStage(&timer);
+    reportStage("chen", &timer, size, kept);
+
+    startStage(&timer);
+    sortIndexEntries(table.entries, table.count, jobs);
+    endStage(&timer);
+    reportStage("sap xep", &timer, size, table.count);
+
+    startStage(&timer);
+    printIndexTable(&table, outputFile);
+    endStage(&timer);
+    reportStage("ghi ket qua", &timer, size, table.count);
+    int stagedTerms = table.count;
+    freeIndexTable(&table);
+    freeTokenList(&list);
+
+    /* Duong ong gop nhu l1 (khong -m): tach, loc, chen trong mot lan quet roi sap xep va ghi */
+    initIndexTable(&table);
+    initTokenizer(&tok);
+    startStage(&fused);
+    tokenizeBlock(&tok, corpus, size, &table);
+    finishTokenizer(&tok, &table);
+    sortIndexEntries(table.entries, table.count, jobs);
+    printIndexTable(&table, outputFile);
+    endStage(&fused);
+    reportStage("toan bo", &fused, size, tokenCount);
+
+    if (table.count != stagedTerms) {
+        fprintf(stderr, "Loi: Duong ong gop co %d tu, cac giai doan rieng co %d tu\n", table.count, stagedTerms);
+    }
+    double peakMB = peakRssMB();
+    if (peakMB >= 0) {
+        printf("RSS dinh cua tien trinh: %.1f MB\n", peakMB);
+    }
+
+    remove(outputFile);
+    freeIndexTable(&table);
+    free(corpus);
+    freeVocabulary(&vocab);
+    freeStopWords();
+    freeDocuments();
+
+    return 0;
+}
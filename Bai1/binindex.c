@@ -0,0 +1,311 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "posting.h"
+#include "binindex.h"
+
+/* count phan tu itemSize byte bat dau tu offset nam tron trong tep; khong tinh offset + count * itemSize de tranh tran so */
+static int sectionFits(uint64_t offset, uint64_t count, uint64_t itemSize, size_t size) {
+    return offset <= size && count <= (size - offset) / itemSize;
+}
+
+static int validBinIndex(const BinIndex* index) {
+    const BinIndexHeader* h = index->header;
+    if (index->size < sizeof(BinIndexHeader)) return 0;
+    if (memcmp(h->magic, BIN_INDEX_MAGIC, 4) != 0) return 0;
+    if (h->version != BIN_INDEX_VERSION || h->byteOrder != BIN_INDEX_BYTE_ORDER) return 0;
+    if (!sectionFits(h->blocksOffset, h->blockCount, sizeof(BinTermBlock), index->size)) return 0;
+    if (!sectionFits(h->docStatesOffset, h->documentCount, sizeof(BinDocState), index->size)) return 0;
+    if (!sectionFits(h->skipsOffset, h->skipCount, sizeof(BinSkip), index->size)) return 0;
+    if (!sectionFits(h->termsOffset, h->termsSize, 1, index->size)) return 0;
+    if (!sectionFits(h->postingsOffset, h->postingsSize, 1, index->size)) return 0;
+    if (!sectionFits(h->documentsOffset, h->documentCount, sizeof(uint64_t), index->size)) return 0;
+
+    /* Moi duong dan tai lieu phai bat dau va ket thuc ('\0') ben trong tep */
+    const uint64_t* documents = (const uint64_t*)(index->base + h->documentsOffset);
+    for (uint32_t d = 0; d < h->documentCount; d++) {
+        if (documents[d] >= index->size ||
+            !memchr(index->base + documents[d], '\0', index->size - documents[d])) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int openBinIndex(const char* filename, BinIndex* index) {
+    memset(index, 0, sizeof(BinIndex));
+
+#ifndef _WIN32
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Loi: Khong mo duoc tep chi muc %s\n", filename);
+        return 0;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(BinIndexHeader)) {
+        fprintf(stderr, "Loi: Tep chi muc %s khong hop le\n", filename);
+        close(fd);
+        return 0;
+    }
+    index->size = (size_t)st.st_size;
+    void* data = mmap(NULL, index->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        perror("Loi anh xa tep chi muc");
+        return 0;
+    }
+    index->base = (const unsigned char*)data;
+    index->mapped = 1;
+#else
+    FILE* file = fopen(filename, "rb");
+    if (!file) {
+        fprintf(stderr, "Loi: Khong mo duoc tep chi muc %s\n", filename);
+        return 0;
+    }
+    fseek(file, 0, SEEK_END);
+    index->size = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    unsigned char* data = (unsigned char*)malloc(index->size ? index->size : 1);
+    if (!data || fread(data, 1, index->size, file) != index->size) {
+        fprintf(stderr, "Loi: Khong doc duoc tep chi muc %s\n", filename);
+        free(data);
+        fclose(file);
+        return 0;
+    }
+    fclose(file);
+    index->base = data;
+#endif
+
+    index->header = (const BinIndexHeader*)index->base;
+    if (!validBinIndex(index)) {
+        fprintf(stderr, "Loi: Tep chi muc %s khong hop le\n", filename);
+        closeBinIndex(index);
+        return 0;
+    }
+
+    index->blocks = (const BinTermBlock*)(index->base + index->header->blocksOffset);
+    index->docStates = (const BinDocState*)(index->base + index->header->docStatesOffset);
+    index->skips = (const BinSkip*)(index->base + index->header->skipsOffset);
+    index->terms = index->base + index->header->termsOffset;
+    index->postings = index->base + index->header->postingsOffset;
+    index->documents = (const uint64_t*)(index->base + index->header->documentsOffset);
+    return 1;
+}
+
+void closeBinIndex(BinIndex* index) {
+    if (!index->base) {
+        return;
+    }
+#ifndef _WIN32
+    munmap((void*)index->base, index->size);
+#else
+    free((void*)index->base);
+#endif
+    index->base = NULL;
+}
+
+/* decodeVarint co kiem tra: NULL neu varint vuot qua end hoac dai hon MAX_VARINT_LEN byte */
+static const unsigned char* readVarint(const unsigned char* p, const unsigned char* end, unsigned int* value) {
+    unsigned int v = 0;
+    for (int n = 0; n < MAX_VARINT_LEN && p < end; n++) {
+        unsigned char b = *p++;
+        v |= (unsigned int)(b & 0x7F) << (7 * n);
+        if (!(b & 0x80)) {
+            *value = v;
+            return p;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Giai ma mot ban ghi tu; term->word phai dang chua tu truoc do trong cung nhom (hoac "" voi tu dau nhom).
+ * Tra ve NULL neu ban ghi hong: vuot qua khoi tu, tu dai qua BIN_MAX_TERM_LEN, danh sach dong /
+ * diem nhay nam ngoai phan cua chung, hoac diem nhay tro ra ngoai danh sach dong cua tu.
+ */
+static const unsigned char* decodeTerm(const unsigned char* p, BinTerm* term, uint64_t* postingOffset,
+                                       uint64_t* skipOffset, const BinIndex* index) {
+    const unsigned char* end = index->terms + index->header->termsSize;
+    unsigned int prefix, suffix, count, size, skipCount;
+    if (!(p = readVarint(p, end, &prefix)) || !(p = readVarint(p, end, &suffix))) {
+        return NULL;
+    }
+    if (prefix > strlen(term->word) || (uint64_t)prefix + suffix >= BIN_MAX_TERM_LEN ||
+        suffix > (size_t)(end - p)) {
+        return NULL;
+    }
+    memcpy(term->word + prefix, p, suffix);
+    term->word[prefix + suffix] = '\0';
+    p += suffix;
+    if (!(p = readVarint(p, end, &count)) || !(p = readVarint(p, end, &size)) ||
+        !(p = readVarint(p, end, &skipCount))) {
+        return NULL;
+    }
+    if (!sectionFits(*postingOffset, size, 1, index->header->postingsSize) ||
+        !sectionFits(*skipOffset, skipCount, 1, index->header->skipCount)) {
+        return NULL;
+    }
+
+    /* Diem nhay phai tro vao trong danh sach dong cua chinh tu nay */
+    const BinSkip* skips = index->skips + *skipOffset;
+    for (unsigned int k = 0; k < skipCount; k++) {
+        if (skips[k].offset > size) {
+            return NULL;
+        }
+    }
+
+    term->count = count;
+    term->postings = index->postings + *postingOffset;
+    term->postingSize = size;
+    term->skips = skips;
+    term->skipCount = skipCount;
+    *postingOffset += size;
+    *skipOffset += skipCount;
+    return p;
+}
+
+static void reportCorruptIndex(void) {
+    fprintf(stderr, "Loi: Tep chi muc bi hong\n");
+}
+
+int findBinTerm(const BinIndex* index, const char* word, BinTerm* term) {
+    uint32_t blockCount = index->header->blockCount;
+    uint64_t termsSize = index->header->termsSize;
+    const unsigned char* end = index->terms + termsSize;
+    if (blockCount == 0) {
+        return 0;
+    }
+
+    /* Nhom cuoi cung co tu dau <= word */
+    uint32_t lo = 0, hi = blockCount;
+    while (hi - lo > 1) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (index->blocks[mid].termOffset >= termsSize) {
+            reportCorruptIndex();
+            return 0;
+        }
+        const unsigned char* p = index->terms + index->blocks[mid].termOffset;
+        unsigned int prefix, suffix;
+        if (!(p = readVarint(p, end, &prefix)) || !(p = readVarint(p, end, &suffix)) ||
+            suffix > (size_t)(end - p)) {
+            reportCorruptIndex();
+            return 0;
+        }
+        size_t wordLen = strlen(word);
+        int cmp = memcmp(p, word, suffix < wordLen ? suffix : wordLen);
+        if (cmp == 0) {
+            cmp = (suffix > wordLen) - (suffix < wordLen);
+        }
+        if (cmp <= 0) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    uint32_t first = lo * BIN_TERMS_PER_BLOCK;
+    uint32_t last = first + BIN_TERMS_PER_BLOCK;
+    if (last > index->header->termCount) {
+        last = index->header->termCount;
+    }
+
+    if (index->blocks[lo].termOffset > termsSize) {
+        reportCorruptIndex();
+        return 0;
+    }
+    const unsigned char* p = index->terms + index->blocks[lo].termOffset;
+    uint64_t postingOffset = index->blocks[lo].postingOffset;
+    uint64_t skipOffset = index->blocks[lo].skipOffset;
+    term->word[0] = '\0';
+    for (uint32_t i = first; i < last; i++) {
+        p = decodeTerm(p, term, &postingOffset, &skipOffset, index);
+        if (!p) {
+            reportCorruptIndex();
+            return 0;
+        }
+        int cmp = strcmp(term->word, word);
+        if (cmp == 0) {
+            return 1;
+        }
+        if (cmp > 0) {
+            break;
+        }
+    }
+    return 0;
+}
+
+const char* binIndexDocument(const BinIndex* index, int docId) {
+    if (docId < 0 || (uint32_t)docId >= index->header->documentCount) {
+        return NULL;
+    }
+    return (const char*)(index->base + index->documents[docId]);
+}
+
+const BinDocState* binIndexDocState(const BinIndex* index, int docId) {
+    if (docId < 0 || (uint32_t)docId >= index->header->documentCount) {
+        return NULL;
+    }
+    return &index->docStates[docId];
+}
+
+/* Cap cuoi cung cua tu: nhay toi diem nhay cuoi roi giai ma toi da BIN_SKIP_INTERVAL cap */
+void lastBinPosting(const BinTerm* term, int* doc, int* line) {
+    PostingCursor cursor;
+    initPostingCursor(&cursor, term->postings, term->postingSize);
+    if (term->skipCount > 0) {
+        const BinSkip* skip = &term->skips[term->skipCount - 1];
+        cursor.p = term->postings + skip->offset;
+        cursor.doc = (int)skip->doc;
+        cursor.line = (int)skip->line;
+    }
+    while (nextPosting(&cursor)) {
+    }
+    *doc = cursor.doc;
+    *line = cursor.line;
+}
+
+/* FNV-1a cua toi da BIN_TAIL_LEN byte cuoi cua tail[0..size) */
+uint32_t binTailHash(const unsigned char* tail, size_t size) {
+    uint32_t h = 2166136261u;
+    size_t i = size > BIN_TAIL_LEN ? size - BIN_TAIL_LEN : 0;
+    for (; i < size; i++) {
+        h ^= tail[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+void initBinTermIterator(BinTermIterator* it, const BinIndex* index) {
+    it->index = index;
+    it->next = 0;
+    it->p = index->terms;
+    it->postingOffset = 0;
+    it->skipOffset = 0;
+    it->term.word[0] = '\0';
+    it->corrupt = 0;
+}
+
+int nextBinTerm(BinTermIterator* it) {
+    if (it->next >= it->index->header->termCount) {
+        return 0;
+    }
+    if (it->next % BIN_TERMS_PER_BLOCK == 0) {
+        it->term.word[0] = '\0';
+    }
+    it->p = decodeTerm(it->p, &it->term, &it->postingOffset, &it->skipOffset, it->index);
+    if (!it->p) {
+        reportCorruptIndex();
+        it->corrupt = 1;
+        return 0;
+    }
+    it->next++;
+    return 1;
+}
@@ -0,0 +1,137 @@
+#ifndef __BININDEX_H__
+#define __BININDEX_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Tep chi muc nhi phan (thu tu byte cua may ghi):
+ *
+ *   BinIndexHeader
+ *   khoi danh sach dong           noi lien cac danh sach da ma hoa (posting.h)
+ *   BinTermBlock[blockCount]      moc cua moi nhom BIN_TERMS_PER_BLOCK tu
+ *   BinDocState[documentCount]    vi tri da lap chi muc cua moi tai lieu (cho che do cap nhat -u)
+ *   BinSkip[skipCount]            diem nhay cua moi tu, cu BIN_SKIP_INTERVAL cap mot diem
+ *   khoi tu                       moi tu: varint tien to chung, varint do dai phan con lai,
+ *                                 phan con lai, varint count, varint so byte danh sach dong,
+ *                                 varint so diem nhay
+ *   uint64_t[documentCount]       vi tri cac duong dan tai lieu (ket thuc bang '\0')
+ *   cac duong dan tai lieu
+ *
+ * Cac phan duoc tim qua offset trong header (canh le 8 byte khi can); danh sach dong dung dau
+ * de bo ghi co the ghi thang tung tu ma khong can biet truoc kich thuoc cac phan khac.
+ * Tu dau moi nhom duoc ghi day du nen tim kiem nhi phan tren cac moc, roi giai ma
+ * toi da BIN_TERMS_PER_BLOCK tu trong nhom. Tep duoc mmap va doc truc tiep, khong phan tich truoc.
+ */
+
+#define BIN_INDEX_MAGIC "KIDX"
+#define BIN_INDEX_VERSION 4
+#define BIN_INDEX_BYTE_ORDER 0x01020304u
+#define BIN_TERMS_PER_BLOCK 16
+#define BIN_SKIP_INTERVAL 64
+#define BIN_MAX_TERM_LEN 256
+#define BIN_TAIL_LEN 64
+
+/* BinIndexHeader.flags */
+#define BIN_INDEX_UTF8 1            /* lap chi muc voi -U: tu la chuoi UTF-8 da doi chu thuong */
+
+/* BinDocState.flags */
+#define BIN_DOC_AFTER_PUNCT 1       /* byte tiep theo dung ngay sau dau ket thuc cau hoac dau dong */
+#define BIN_DOC_MID_WORD 2          /* byte cuoi da lap chi muc la chu cai */
+#define BIN_DOC_NO_RESUME 4         /* doc tu stdin, khong the doc tiep */
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t termCount;
+    uint32_t blockCount;
+    uint32_t documentCount;
+    uint32_t flags;
+    uint32_t reserved;
+    uint64_t blocksOffset;
+    uint64_t docStatesOffset;
+    uint64_t skipsOffset;
+    uint64_t skipCount;
+    uint64_t termsOffset;
+    uint64_t termsSize;
+    uint64_t postingsOffset;
+    uint64_t postingsSize;
+    uint64_t documentsOffset;
+} BinIndexHeader;
+
+typedef struct {
+    uint64_t termOffset;        /* tinh tu dau khoi tu */
+    uint64_t postingOffset;     /* tinh tu dau khoi danh sach dong */
+    uint64_t skipOffset;        /* chi so trong mang BinSkip */
+} BinTermBlock;
+
+/*
+ * Trang thai bo tach tu o cuoi phan da lap chi muc cua mot tai lieu: che do cap nhat doc tiep
+ * tu indexedBytes voi so dong lastLine. tailHash (binTailHash) phat hien tep bi sua thay vi noi them.
+ */
+typedef struct {
+    uint64_t indexedBytes;
+    uint32_t lastLine;
+    uint32_t flags;
+    uint32_t tailHash;
+    uint32_t reserved;
+} BinDocState;
+
+/*
+ * Diem nhay thu k cua mot tu cho phep giai ma tiep tu cap thu (k + 1) * BIN_SKIP_INTERVAL:
+ * doc/line la cap dung ngay truoc do, offset la vi tri byte trong danh sach dong cua tu.
+ */
+typedef struct {
+    uint32_t doc;
+    uint32_t line;
+    uint32_t offset;
+} BinSkip;
+
+typedef struct {
+    const unsigned char* base;
+    size_t size;
+    const BinIndexHeader* header;
+    const BinTermBlock* blocks;
+    const BinDocState* docStates;
+    const BinSkip* skips;
+    const unsigned char* terms;
+    const unsigned char* postings;
+    const uint64_t* documents;
+    int mapped;
+} BinIndex;
+
+typedef struct {
+    char word[BIN_MAX_TERM_LEN];
+    unsigned int count;
+    const unsigned char* postings;
+    size_t postingSize;
+    const BinSkip* skips;
+    uint32_t skipCount;
+} BinTerm;
+
+/* Duyet moi tu theo thu tu tu dien */
+typedef struct {
+    const BinIndex* index;
+    uint32_t next;
+    const unsigned char* p;
+    uint64_t postingOffset;
+    uint64_t skipOffset;
+    BinTerm term;
+    int corrupt;                /* nextBinTerm dung vi gap ban ghi hong, khong phai vi het tu */
+} BinTermIterator;
+
+int openBinIndex(const char* filename, BinIndex* index);
+void closeBinIndex(BinIndex* index);
+
+int findBinTerm(const BinIndex* index, const char* word, BinTerm* term);
+const char* binIndexDocument(const BinIndex* index, int docId);
+const BinDocState* binIndexDocState(const BinIndex* index, int docId);
+void lastBinPosting(const BinTerm* term, int* doc, int* line);
+
+uint32_t binTailHash(const unsigned char* tail, size_t size);
+
+void initBinTermIterator(BinTermIterator* it, const BinIndex* index);
+int nextBinTerm(BinTermIterator* it);
+
+#endif
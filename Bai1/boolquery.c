@@ -0,0 +1,656 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "boolquery.h"
+#include "unicode.h"
+
+#define MAX_QUERY_TOKENS 256
+#define MAX_QUERY_WORD 256
+
+/* Noi dung mot tai lieu goc va vi tri dau moi dong, nap khi can kiem tra cum tu */
+typedef struct {
+    const unsigned char* data;
+    size_t size;
+    size_t* lineStarts;
+    int lineCount;
+    int loaded;
+    int mapped;
+} DocText;
+
+struct QuerySource_ {
+    const BinIndex* index;
+    int utf8;           /* chi muc lap voi -U */
+    DocText* docs;
+    int docCount;
+};
+
+typedef enum {
+    QT_WORD, QT_AND, QT_OR, QT_NOT, QT_LPAR, QT_RPAR, QT_QUOTE, QT_END
+} QueryTokenType;
+
+typedef struct {
+    QueryTokenType type;
+    char text[MAX_QUERY_WORD];
+} QueryToken;
+
+typedef struct {
+    QueryToken* tokens;
+    int count;
+    int pos;
+    const BinIndex* index;
+    QuerySource* source;
+    int failed;
+} QueryParser;
+
+static QueryNode* parseOr(QueryParser* parser);
+
+static void* checkedMalloc(size_t size) {
+    void* p = malloc(size);
+    if (!p) {
+        perror("Loi cap phat bo nho cho truy van");
+        exit(1);
+    }
+    return p;
+}
+
+static QueryNode* newNode(QueryKind kind) {
+    QueryNode* node = (QueryNode*)checkedMalloc(sizeof(QueryNode));
+    memset(node, 0, sizeof(QueryNode));
+    node->kind = kind;
+    return node;
+}
+
+static void addChild(QueryNode* node, QueryNode* child) {
+    node->children = (QueryNode**)realloc(node->children, (node->childCount + 1) * sizeof(QueryNode*));
+    if (!node->children) {
+        perror("Loi cap phat bo nho cho truy van");
+        exit(1);
+    }
+    node->children[node->childCount++] = child;
+}
+
+/******************* Nguon van ban cho cum tu ******************************/
+
+QuerySource* createQuerySource(const BinIndex* index) {
+    QuerySource* source = (QuerySource*)checkedMalloc(sizeof(QuerySource));
+    source->index = index;
+    source->utf8 = (index->header->flags & BIN_INDEX_UTF8) != 0;
+    if (source->utf8) {
+        initUnicodeTables();
+    }
+    source->docCount = (int)index->header->documentCount;
+    source->docs = (DocText*)calloc(source->docCount > 0 ? source->docCount : 1, sizeof(DocText));
+    if (!source->docs) {
+        perror("Loi cap phat bo nho cho truy van");
+        exit(1);
+    }
+    return source;
+}
+
+void freeQuerySource(QuerySource* source) {
+    for (int d = 0; d < source->docCount; d++) {
+        DocText* doc = &source->docs[d];
+#ifndef _WIN32
+        if (doc->mapped) {
+            munmap((void*)doc->data, doc->size);
+        }
+#endif
+        if (!doc->mapped) {
+            free((void*)doc->data);
+        }
+        free(doc->lineStarts);
+    }
+    free(source->docs);
+    free(source);
+}
+
+static DocText* loadDocText(QuerySource* source, int docId) {
+    if (docId < 0 || docId >= source->docCount) {
+        return NULL;
+    }
+    DocText* doc = &source->docs[docId];
+    if (doc->loaded) {
+        return doc->lineStarts ? doc : NULL;
+    }
+    doc->loaded = 1;
+
+    const char* path = binIndexDocument(source->index, docId);
+    FILE* file = path ? fopen(path, "rb") : NULL;
+    if (!file) {
+        fprintf(stderr, "Loi: Khong mo duoc tai lieu %s de kiem tra cum tu\n", path ? path : "?");
+        return NULL;
+    }
+
+#ifndef _WIN32
+    struct stat st;
+    if (fstat(fileno(file), &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+        if (data != MAP_FAILED) {
+            doc->data = (const unsigned char*)data;
+            doc->size = (size_t)st.st_size;
+            doc->mapped = 1;
+        }
+    }
+#endif
+    if (!doc->mapped) {
+        size_t capacity = 1 << 16, size = 0, n;
+        unsigned char* data = (unsigned char*)checkedMalloc(capacity);
+        while ((n = fread(data + size, 1, capacity - size, file)) > 0) {
+            size += n;
+            if (size == capacity) {
+                capacity *= 2;
+                data = (unsigned char*)realloc(data, capacity);
+                if (!data) {
+                    perror("Loi cap phat bo nho cho truy van");
+                    exit(1);
+                }
+            }
+        }
+        doc->data = data;
+        doc->size = size;
+    }
+    fclose(file);
+
+    int capacity = 1024;
+    doc->lineStarts = (size_t*)checkedMalloc(capacity * sizeof(size_t));
+    doc->lineStarts[doc->lineCount++] = 0;
+    const unsigned char* p = doc->data;
+    const unsigned char* end = doc->data + doc->size;
+    while (p < end && (p = memchr(p, '\n', end - p)) != NULL) {
+        p++;
+        if (doc->lineCount == capacity) {
+            capacity *= 2;
+            doc->lineStarts = (size_t*)realloc(doc->lineStarts, capacity * sizeof(size_t));
+            if (!doc->lineStarts) {
+                perror("Loi cap phat bo nho cho truy van");
+                exit(1);
+            }
+        }
+        doc->lineStarts[doc->lineCount++] = (size_t)(p - doc->data);
+    }
+    return doc;
+}
+
+static int sameWord(const unsigned char* text, size_t len, const char* word, int utf8) {
+    if (utf8) {
+        char folded[MAX_QUERY_WORD];
+        foldUtf8Word(folded, sizeof(folded), (const char*)text, len);
+        return strcmp(folded, word) == 0;
+    }
+    size_t i = 0;
+    while (i < len && word[i] && word[i] == tolower(text[i])) i++;
+    return i == len && word[i] == '\0';
+}
+
+/* So byte cua ky tu tai p; *letter = 1 neu la chu cai theo cach tach tu cua bo lap chi muc */
+static int scanChar(const unsigned char* p, const unsigned char* end, int utf8, int* letter) {
+    if (!utf8 || *p < 0x80) {
+        *letter = isalpha(*p) != 0;
+        return 1;
+    }
+    uint32_t cp;
+    int n = decodeUtf8(p, (size_t)(end - p), &cp);
+    if (n <= 0) {
+        *letter = 0;
+        return 1;
+    }
+    *letter = unicodeClass(cp) == UNI_LETTER;
+    return n;
+}
+
+/* Bo qua cac ky tu khong phai chu cai (skipLetters = 0) hoac cac chu cai (skipLetters = 1) */
+static const unsigned char* skipChars(const unsigned char* p, const unsigned char* end, int utf8, int skipLetters) {
+    while (p < end) {
+        int letter;
+        int n = scanChar(p, end, utf8, &letter);
+        if (letter != skipLetters) {
+            break;
+        }
+        p += n;
+    }
+    return p;
+}
+
+/* Dong co chua words[0..wordCount) lien tiep nhau (theo cach tach tu cua bo lap chi muc) khong */
+static int lineHasPhrase(QuerySource* source, uint64_t key, char** words, int wordCount) {
+    DocText* doc = loadDocText(source, QUERY_DOC(key));
+    int line = QUERY_LINE(key);
+    if (!doc || line < 1 || line > doc->lineCount) {
+        return 0;
+    }
+
+    const unsigned char* p = doc->data + doc->lineStarts[line - 1];
+    const unsigned char* end = line < doc->lineCount ? doc->data + doc->lineStarts[line] : doc->data + doc->size;
+
+    int utf8 = source->utf8;
+    while (p < end) {
+        p = skipChars(p, end, utf8, 0);
+        if (p >= end) break;
+
+        /* Thu khop ca cum bat dau tu tu nay */
+        const unsigned char* q = p;
+        int matched = 0;
+        while (matched < wordCount) {
+            q = skipChars(q, end, utf8, 0);
+            const unsigned char* start = q;
+            q = skipChars(q, end, utf8, 1);
+            if (q == start || !sameWord(start, (size_t)(q - start), words[matched], utf8)) {
+                break;
+            }
+            matched++;
+        }
+        if (matched == wordCount) {
+            return 1;
+        }
+
+        p = skipChars(p, end, utf8, 1);
+    }
+    return 0;
+}
+
+/******************* Duyet ******************************/
+
+static uint64_t termKey(const PostingCursor* cursor) {
+    return QUERY_KEY(cursor->doc, cursor->line);
+}
+
+static uint64_t skipKey(const BinSkip* skip) {
+    return QUERY_KEY(skip->doc, skip->line);
+}
+
+/*
+ * Nhay bang diem nhay: diem k dung duoc neu no o sau vi tri hien tai va cap truoc no < target.
+ * Tim diem xa nhat nhu vay bang tim kiem luy thua (galloping) roi nhi phan.
+ */
+static void seekTerm(QueryNode* node, uint64_t target) {
+    uint32_t first = node->consumed / BIN_SKIP_INTERVAL;
+    if (first < node->skipCount && skipKey(&node->skips[first]) < target) {
+        uint32_t lo = first, step = 1;
+        while (lo + step < node->skipCount && skipKey(&node->skips[lo + step]) < target) {
+            lo += step;
+            step *= 2;
+        }
+        uint32_t hi = lo + step < node->skipCount ? lo + step : node->skipCount;
+        while (hi - lo > 1) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            if (skipKey(&node->skips[mid]) < target) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+        const BinSkip* skip = &node->skips[lo];
+        node->cursor.p = node->postings + skip->offset;
+        node->cursor.doc = (int)skip->doc;
+        node->cursor.line = (int)skip->line;
+        node->consumed = (lo + 1) * BIN_SKIP_INTERVAL;
+        node->current = skipKey(skip);
+    }
+
+    while (node->current < target) {
+        if (!nextPosting(&node->cursor)) {
+            node->current = QUERY_END;
+            return;
+        }
+        node->consumed++;
+        node->current = termKey(&node->cursor);
+    }
+}
+
+static void seekAnd(QueryNode* node, uint64_t target) {
+    int aligned = 0;
+    while (!aligned) {
+        aligned = 1;
+        for (int i = 0; i < node->childCount; i++) {
+            uint64_t key = seekQuery(node->children[i], target);
+            if (key == QUERY_END) {
+                node->current = QUERY_END;
+                return;
+            }
+            if (key > target) {
+                target = key;
+                aligned = 0;
+            }
+        }
+    }
+    node->current = target;
+}
+
+static void seekOr(QueryNode* node, uint64_t target) {
+    uint64_t smallest = QUERY_END;
+    for (int i = 0; i < node->childCount; i++) {
+        uint64_t key = seekQuery(node->children[i], target);
+        if (key < smallest) {
+            smallest = key;
+        }
+    }
+    node->current = smallest;
+}
+
+static void seekAndNot(QueryNode* node, uint64_t target) {
+    QueryNode* left = node->children[0];
+    QueryNode* right = node->children[1];
+    uint64_t key = seekQuery(left, target);
+    while (key != QUERY_END && seekQuery(right, key) == key) {
+        key = seekQuery(left, key + 1);
+    }
+    node->current = key;
+}
+
+/*
+ * Quet tung dong cua tep goc tu target. Khong dung danh sach dong: tu dung khong duoc lap chi muc, va
+ * bo loc danh tu rieng bo moi tu viet hoa giua cau, nen dong chua cum tu co the vang mat o moi tu.
+ */
+static void seekPhrase(QueryNode* node, uint64_t target) {
+    QuerySource* source = node->source;
+    int line = QUERY_LINE(target) > 0 ? QUERY_LINE(target) : 1;
+    for (int d = QUERY_DOC(target); d < source->docCount; d++, line = 1) {
+        DocText* doc = loadDocText(source, d);
+        if (!doc) {
+            continue;
+        }
+        for (; line <= doc->lineCount; line++) {
+            uint64_t key = QUERY_KEY(d, line);
+            if (lineHasPhrase(source, key, node->words, node->wordCount)) {
+                node->current = key;
+                return;
+            }
+        }
+    }
+    node->current = QUERY_END;
+}
+
+/* Dua node toi ket qua dau tien >= target; khong bao gio lui lai */
+uint64_t seekQuery(QueryNode* node, uint64_t target) {
+    if (node->current >= target) {
+        return node->current;
+    }
+    switch (node->kind) {
+    case Q_TERM: seekTerm(node, target); break;
+    case Q_AND: seekAnd(node, target); break;
+    case Q_OR: seekOr(node, target); break;
+    case Q_AND_NOT: seekAndNot(node, target); break;
+    case Q_PHRASE: seekPhrase(node, target); break;
+    default: node->current = QUERY_END; break;
+    }
+    return node->current;
+}
+
+uint64_t nextQueryMatch(QueryNode* node) {
+    if (node->current == QUERY_END) {
+        return QUERY_END;
+    }
+    return seekQuery(node, node->current + 1);
+}
+
+/******************* Phan tich cu phap ******************************/
+
+static void lowerWord(char* dst, const char* src, size_t len, int utf8) {
+    if (utf8) {
+        foldUtf8Word(dst, MAX_QUERY_WORD, src, len);
+        return;
+    }
+    if (len >= MAX_QUERY_WORD) {
+        len = MAX_QUERY_WORD - 1;
+    }
+    for (size_t i = 0; i < len; i++) {
+        dst[i] = (char)tolower((unsigned char)src[i]);
+    }
+    dst[len] = '\0';
+}
+
+static int tokenizeQuery(const char* text, QueryToken* tokens, int utf8) {
+    int count = 0;
+    const char* p = text;
+    while (*p) {
+        if (count == MAX_QUERY_TOKENS - 1) {
+            fprintf(stderr, "Loi truy van: qua nhieu thanh phan\n");
+            return -1;
+        }
+        QueryToken* tok = &tokens[count];
+        if (isspace((unsigned char)*p)) {
+            p++;
+            continue;
+        }
+        if (*p == '(' || *p == ')' || *p == '"') {
+            tok->type = *p == '(' ? QT_LPAR : *p == ')' ? QT_RPAR : QT_QUOTE;
+            tok->text[0] = '\0';
+            p++;
+            count++;
+            continue;
+        }
+        const char* start = p;
+        while (*p && !isspace((unsigned char)*p) && *p != '(' && *p != ')' && *p != '"') p++;
+        size_t len = (size_t)(p - start);
+        if (len == 3 && strncmp(start, "AND", 3) == 0) {
+            tok->type = QT_AND;
+        } else if (len == 2 && strncmp(start, "OR", 2) == 0) {
+            tok->type = QT_OR;
+        } else if (len == 3 && strncmp(start, "NOT", 3) == 0) {
+            tok->type = QT_NOT;
+        } else {
+            tok->type = QT_WORD;
+        }
+        lowerWord(tok->text, start, len, utf8);
+        count++;
+    }
+    tokens[count].type = QT_END;
+    return count;
+}
+
+static QueryToken* peekToken(QueryParser* parser) {
+    return &parser->tokens[parser->pos];
+}
+
+static QueryNode* makeTermNode(const BinIndex* index, const char* word) {
+    BinTerm term;
+    if (!findBinTerm(index, word, &term)) {
+        return newNode(Q_EMPTY);
+    }
+    QueryNode* node = newNode(Q_TERM);
+    node->postings = term.postings;
+    node->skips = term.skips;
+    node->skipCount = term.skipCount;
+    initPostingCursor(&node->cursor, term.postings, term.postingSize);
+    return node;
+}
+
+static QueryNode* parsePhrase(QueryParser* parser) {
+    QueryNode* node = newNode(Q_PHRASE);
+    node->source = parser->source;
+
+    while (peekToken(parser)->type != QT_QUOTE) {
+        QueryToken* tok = peekToken(parser);
+        if (tok->type == QT_END) {
+            fprintf(stderr, "Loi truy van: thieu dau \" dong cum tu\n");
+            parser->failed = 1;
+            return node;
+        }
+        parser->pos++;
+
+        /* Tach thanh cac tu chu cai nhu bo lap chi muc */
+        int utf8 = (parser->index->header->flags & BIN_INDEX_UTF8) != 0;
+        const unsigned char* p = (const unsigned char*)tok->text;
+        const unsigned char* end = p + strlen(tok->text);
+        while (p < end) {
+            p = skipChars(p, end, utf8, 0);
+            if (p >= end) break;
+            const unsigned char* start = p;
+            p = skipChars(p, end, utf8, 1);
+
+            char word[MAX_QUERY_WORD];
+            lowerWord(word, (const char*)start, (size_t)(p - start), utf8);
+            node->words = (char**)realloc(node->words, (node->wordCount + 1) * sizeof(char*));
+            if (!node->words) {
+                perror("Loi cap phat bo nho cho truy van");
+                exit(1);
+            }
+            node->words[node->wordCount++] = strdup(word);
+        }
+    }
+    parser->pos++;
+
+    if (node->wordCount == 0) {
+        fprintf(stderr, "Loi truy van: cum tu rong\n");
+        parser->failed = 1;
+        return node;
+    }
+
+    /* Cum tu chi kiem tra duoc tren van ban goc: thieu mot tai lieu thi ket qua se sai, nen tu choi */
+    for (int d = 0; d < parser->source->docCount; d++) {
+        if (!loadDocText(parser->source, d)) {
+            fprintf(stderr, "Loi truy van: cum tu can doc duoc moi tai lieu goc\n");
+            parser->failed = 1;
+            return node;
+        }
+    }
+    return node;
+}
+
+static QueryNode* parsePrimary(QueryParser* parser) {
+    QueryToken* tok = peekToken(parser);
+    switch (tok->type) {
+    case QT_NOT: {
+        parser->pos++;
+        QueryNode* node = newNode(Q_NOT);
+        addChild(node, parsePrimary(parser));
+        return node;
+    }
+    case QT_WORD:
+        parser->pos++;
+        return makeTermNode(parser->index, tok->text);
+    case QT_QUOTE:
+        parser->pos++;
+        return parsePhrase(parser);
+    case QT_LPAR: {
+        parser->pos++;
+        QueryNode* node = parseOr(parser);
+        if (peekToken(parser)->type != QT_RPAR) {
+            fprintf(stderr, "Loi truy van: thieu ')'\n");
+            parser->failed = 1;
+        } else {
+            parser->pos++;
+        }
+        return node;
+    }
+    default:
+        fprintf(stderr, "Loi truy van: can mot tu, cum tu hoac '('\n");
+        parser->failed = 1;
+        return newNode(Q_EMPTY);
+    }
+}
+
+static QueryNode* parseAnd(QueryParser* parser) {
+    QueryNode* node = newNode(Q_AND);
+    QueryNode* excluded = NULL;
+
+    for (;;) {
+        QueryNode* operand = parsePrimary(parser);
+        if (operand->kind == Q_NOT) {
+            if (!excluded) {
+                excluded = newNode(Q_OR);
+            }
+            addChild(excluded, operand->children[0]);
+            operand->childCount = 0;
+            freeQuery(operand);
+        } else {
+            addChild(node, operand);
+        }
+
+        QueryTokenType next = peekToken(parser)->type;
+        if (next == QT_AND) {
+            parser->pos++;
+        } else if (next != QT_WORD && next != QT_QUOTE && next != QT_LPAR && next != QT_NOT) {
+            break;
+        }
+        if (parser->failed) {
+            break;
+        }
+    }
+
+    if (node->childCount == 0) {
+        fprintf(stderr, "Loi truy van: NOT phai di kem mot dieu kien khac (a AND NOT b)\n");
+        parser->failed = 1;
+    }
+
+    QueryNode* result = node;
+    if (node->childCount == 1) {
+        result = node->children[0];
+        node->childCount = 0;
+        freeQuery(node);
+    }
+    if (excluded) {
+        QueryNode* diff = newNode(Q_AND_NOT);
+        addChild(diff, result);
+        addChild(diff, excluded);
+        result = diff;
+    }
+    return result;
+}
+
+static QueryNode* parseOr(QueryParser* parser) {
+    QueryNode* first = parseAnd(parser);
+    if (peekToken(parser)->type != QT_OR) {
+        return first;
+    }
+
+    QueryNode* node = newNode(Q_OR);
+    addChild(node, first);
+    while (!parser->failed && peekToken(parser)->type == QT_OR) {
+        parser->pos++;
+        addChild(node, parseAnd(parser));
+    }
+    return node;
+}
+
+QueryNode* parseQuery(const char* text, const BinIndex* index, QuerySource* source) {
+    QueryToken* tokens = (QueryToken*)checkedMalloc(MAX_QUERY_TOKENS * sizeof(QueryToken));
+    QueryParser parser;
+    parser.tokens = tokens;
+    parser.pos = 0;
+    parser.index = index;
+    parser.source = source;
+    parser.failed = 0;
+
+    if (tokenizeQuery(text, tokens, (index->header->flags & BIN_INDEX_UTF8) != 0) <= 0) {
+        if (!parser.failed) {
+            fprintf(stderr, "Loi truy van: truy van rong\n");
+        }
+        free(tokens);
+        return NULL;
+    }
+
+    QueryNode* node = parseOr(&parser);
+    if (!parser.failed && peekToken(&parser)->type != QT_END) {
+        fprintf(stderr, "Loi truy van: thua thanh phan o cuoi\n");
+        parser.failed = 1;
+    }
+    free(tokens);
+
+    if (parser.failed) {
+        freeQuery(node);
+        return NULL;
+    }
+    return node;
+}
+
+void freeQuery(QueryNode* node) {
+    for (int i = 0; i < node->childCount; i++) {
+        freeQuery(node->children[i]);
+    }
+    free(node->children);
+    for (int i = 0; i < node->wordCount; i++) {
+        free(node->words[i]);
+    }
+    free(node->words);
+    free(node);
+}
@@ -0,0 +1,70 @@
+#ifndef __BOOLQUERY_H__
+#define __BOOLQUERY_H__
+
+#include <stdint.h>
+#include "posting.h"
+#include "binindex.h"
+
+/*
+ * Truy van tren chi muc nhi phan:
+ *
+ *   bieu_thuc := hoac
+ *   hoac      := va ( OR va )*
+ *   va        := phu ( [AND] phu )*        hai thanh phan dung canh nhau la AND
+ *   phu       := NOT phu | tu | "cum tu" | ( bieu_thuc )
+ *
+ * NOT chi dung duoc ben phai AND (a AND NOT b). Ket qua la cac cap (tai lieu, dong) tang dan,
+ * sinh dan moi lan goi nextQueryMatch. Cum tu duoc tim bang cach quet cac dong cua tep goc
+ * (tu dung va danh tu rieng khong co day du trong danh sach dong), nen cac tep goc phai con doc duoc.
+ */
+
+#define QUERY_END UINT64_MAX
+#define QUERY_KEY(doc, line) (((uint64_t)(uint32_t)(doc) << 32) | (uint32_t)(line))
+#define QUERY_DOC(key) ((int)((key) >> 32))
+#define QUERY_LINE(key) ((int)((key) & 0xFFFFFFFFu))
+
+typedef enum {
+    Q_EMPTY,
+    Q_TERM,
+    Q_AND,
+    Q_OR,
+    Q_AND_NOT,
+    Q_NOT,
+    Q_PHRASE
+} QueryKind;
+
+struct QuerySource_;
+
+typedef struct QueryNode_ {
+    QueryKind kind;
+    uint64_t current;               /* cap hien tai; 0 truoc lan dau, QUERY_END khi het */
+
+    /* Q_TERM */
+    PostingCursor cursor;
+    const unsigned char* postings;
+    const BinSkip* skips;
+    uint32_t skipCount;
+    uint32_t consumed;              /* so cap da giai ma */
+
+    /* Q_AND, Q_OR, Q_AND_NOT (children[0] tru children[1]), Q_NOT */
+    struct QueryNode_** children;
+    int childCount;
+
+    /* Q_PHRASE */
+    char** words;
+    int wordCount;
+    struct QuerySource_* source;
+} QueryNode;
+
+typedef struct QuerySource_ QuerySource;
+
+QuerySource* createQuerySource(const BinIndex* index);
+void freeQuerySource(QuerySource* source);
+
+QueryNode* parseQuery(const char* text, const BinIndex* index, QuerySource* source);
+void freeQuery(QueryNode* node);
+
+uint64_t seekQuery(QueryNode* node, uint64_t target);
+uint64_t nextQueryMatch(QueryNode* node);
+
+#endif
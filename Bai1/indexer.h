@@ -0,0 +1,317 @@
+#ifndef __INDEXER_H__
+#define __INDEXER_H__
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "posting.h"
+#include "binindex.h"
+#include "arena.h"
+#include "topk.h"
+
+#define MAX_WORD_LEN 100
+#define MAX_PATH_LEN 4096
+#define INITIAL_DOC_CAP 64
+#define INITIAL_TABLE_CAP 1000
+#define INITIAL_POSTING_CAP 8
+#define INITIAL_HASH_CAP 2048
+#define INITIAL_STOP_CAP 1024
+#define HASH_EMPTY -1
+#define READ_BLOCK_SIZE (1 << 16)
+#define CHUNK_SIZE 32
+#define MAX_RUN_FANIN 64
+#define OUTPUT_BUFFER_SIZE (1 << 20)
+/* ",doc:line" voi hai so 32 bit */
+#define MAX_POSTING_TEXT 24
+#define INSERTION_SORT_MAX 16
+#define PARALLEL_SORT_MIN (1 << 15)
+/* Gioi han tren cua -j */
+#define MAX_JOBS 64
+#define MIN_MEMORY_BUDGET_MB 2
+/* -k khong co -m: bo nho cho bo dem cap tu */
+#define DEFAULT_PAIR_BUDGET_MB 64
+
+#define CLS_ALPHA 1
+#define CLS_NEWLINE 2
+#define CLS_SENTENCE 4
+#define CLS_BLANK 8
+
+typedef struct {
+    char *word;
+    unsigned int hash;
+    int count;
+    unsigned char *postings;    /* cap (tai lieu, dong) dang delta + varint, xem encodePosting */
+    int posting_size;
+    int posting_capacity;
+    int last_doc_added;
+    int last_line_added;
+} IndexEntry;
+
+/* -m: cac run da sap xep ghi ra <prefix>.run<so thu tu>; run sau luon chua cac cap lon hon run truoc */
+typedef struct {
+    size_t budget;      /* byte */
+    const char* prefix;
+    int first;          /* run dau tien chua duoc tron */
+    int count;
+    int jobs;           /* so luong sap xep moi run */
+} RunSet;
+
+/* -k: dem cap tu lien tiep; hai tu chi thanh cap khi khong co tu bi loai (tu dung, danh tu rieng) xen giua */
+typedef struct {
+    PairCounter pairs;      /* khoa: (chi so entry tu truoc << 32) | chi so entry tu sau */
+    int previousTerm;       /* -1 neu tu truoc bi loai */
+    int previousDoc;
+} TermStats;
+
+typedef struct {
+    IndexEntry *entries;
+    int count;
+    int capacity;
+    int *buckets;       /* bang bam dia chi mo: luu chi so vao entries, HASH_EMPTY neu trong */
+    int bucketCount;    /* luon la luy thua cua 2 */
+    Arena arena;        /* chua word va postings cua moi entry */
+    RunSet *runs;       /* khac NULL: ghi bang ra dia moi khi vuot runs->budget */
+    TermStats *stats;   /* khac NULL (-k): chi dem tu va cap tu, khong luu danh sach dong */
+} IndexTable;
+
+/* Tu da tach nhung chua loc va chen, de do rieng tung giai doan (l1bench) */
+typedef struct {
+    size_t offset;          /* vi tri tu (chu thuong, ket thuc '\0') trong TokenList.text */
+    int lineNumber;
+    unsigned char length;
+    unsigned char proper;   /* chu hoa dau va khong dung sau dau cau */
+} Token;
+
+typedef struct {
+    Token* tokens;
+    int count;
+    int capacity;
+    char* text;
+    size_t textSize;
+    size_t textCapacity;
+} TokenList;
+
+typedef struct {
+    char lowercaseWord[MAX_WORD_LEN];
+    int firstChar;
+    int wordIndex;
+    int docId;
+    int lineNumber;
+    int afterPunctuation;
+    TokenList* tokens;      /* khac NULL: chi ghi tu vao day, bo qua loc va chen */
+    unsigned char pending[4];   /* -U: ky tu UTF-8 bi cat o cuoi khoi truoc */
+    int pendingLength;
+} Tokenizer;
+
+/* Khoa sap xep: con tro toi tu va vi tri entry goc, de khong phai hoan doi ca IndexEntry */
+typedef struct {
+    const unsigned char* word;
+    int index;
+} SortKey;
+
+#ifndef _WIN32
+/* Cac nhom chu cai dau duoc chia cho cac luong qua bien dem chung */
+typedef struct {
+    SortKey* keys;
+    const int* bucketStart;     /* 257 phan tu */
+    int nextBucket;
+} SortTask;
+#endif
+
+/* Doc tuan tu mot run, moi lan mot tu */
+typedef struct {
+    FILE* file;
+    char word[MAX_WORD_LEN];
+    int count;
+    int lastDoc;
+    int lastLine;
+    unsigned char* postings;
+    size_t size;
+    size_t capacity;
+} RunReader;
+
+/* Nhan tung tu da tron theo thu tu tu dien */
+typedef void (*EntrySink)(void* context, const IndexEntry* entry);
+
+/* Trang thai ghi chi muc nhi phan tung tu, xem openBinIndexWriter */
+typedef struct {
+    FILE* file;
+    uint32_t termCount;
+    uint64_t postingOffset;
+    unsigned char* blocks;
+    size_t blocksSize, blocksCapacity;
+    unsigned char* skips;
+    size_t skipsSize, skipsCapacity;
+    unsigned char* terms;
+    size_t termsSize, termsCapacity;
+    char previous[MAX_WORD_LEN];
+} BinIndexWriter;
+
+/* Ghi output.txt: tu dinh dang so vao bo dem lon, ghi ra bang write() tung khoi */
+typedef struct {
+#ifndef _WIN32
+    int fd;
+#else
+    FILE* file;         /* che do van ban de giu "\r\n" nhu fprintf truoc day */
+#endif
+    char* buffer;
+    size_t used;
+} TextWriter;
+
+/* Dau ra cua lan tron run cuoi cung */
+typedef struct {
+    TextWriter* text;
+    BinIndexWriter* binary;     /* NULL neu khong ghi chi muc nhi phan */
+} OutputSinks;
+
+/* BIN_TAIL_LEN byte cuoi cung da doc, de tinh BinDocState.tailHash khi doc theo khoi */
+typedef struct {
+    unsigned char bytes[BIN_TAIL_LEN];
+    size_t len;
+} TailWindow;
+
+/* Mat na phan loai cho mot khoi CHUNK_SIZE byte, bit i ung voi byte thu i */
+typedef struct {
+    uint32_t alpha;
+    uint32_t newline;
+    uint32_t sentence;  /* '.', '?', '!' */
+    uint32_t blank;     /* isspace nhung khong phai '\n' */
+} ChunkMasks;
+
+#ifndef _WIN32
+/*
+ * Mot manh [begin, end) cua tep da anh xa (begin luon o ngay sau mot '\n', tru manh dau),
+ * hoac mot day tai lieu [firstDoc, lastDoc) khi lap chi muc nhieu tai lieu.
+ */
+typedef struct {
+    const unsigned char* data;
+    size_t begin;
+    size_t end;
+    int newlines;
+    int startLine;
+    int firstDoc;
+    int lastDoc;
+    int afterPunctuation;   /* trang thai bo tach tu o cuoi manh */
+    IndexTable table;
+} IndexShard;
+
+typedef struct {
+    IndexShard* shards;
+    int shardCount;
+    int* from;
+    int* to;
+    IndexEntry* out;
+    int outCount;
+    Arena arena;        /* danh sach dong noi lai khi tron */
+} MergeTask;
+#endif
+
+/* Tap tu dung: bang bam dia chi mo, kich thuoc luy thua 2, luon con it nhat mot nua o trong */
+typedef struct {
+    char* word;         /* NULL neu o trong */
+    unsigned int hash;
+} StopWordSlot;
+
+extern unsigned char g_charClass[256];
+extern int g_utf8Mode;
+
+extern char** g_documents;
+extern BinDocState* g_docStates;
+extern int g_documentCount;
+extern int g_documentCapacity;
+extern int g_previousDocumentCount;
+
+extern StopWordSlot* g_stopWords;
+extern unsigned int g_stopWordsMask;
+extern int g_stopWordsCount;
+extern uint64_t g_stopWordLengths;
+
+int compareStrings(const void* a, const void* b);
+void sortIndexEntries(IndexEntry* entries, int count, int jobs);
+
+void loadStopWords(const char* filename);
+void addStopWord(const char* word, int length);
+int isStopWord(const char* word, int length);
+void freeStopWords();
+
+unsigned int hashWord(const char* word);
+void growStopWords(void);
+void growHashIndex(IndexTable* table);
+
+void initIndexTable(IndexTable* table);
+IndexEntry* findWord(IndexTable* table, const char* word);
+IndexEntry* addWord(IndexTable* table, const char* word);
+void reservePostings(Arena* arena, IndexEntry* entry, int extra);
+void addLinePosting(Arena* arena, IndexEntry* entry, int docId, int lineNumber);
+void appendPostings(Arena* arena, IndexEntry* dst, const IndexEntry* src);
+void freeIndexTable(IndexTable* table);
+
+void initTokenizer(Tokenizer* tok);
+void initTokenList(TokenList* list);
+void appendToken(TokenList* list, const Tokenizer* tok);
+void freeTokenList(TokenList* list);
+void flushWord(Tokenizer* tok, IndexTable* table);
+void initCharClasses(void);
+void classifyScalar(const unsigned char* p, int n, ChunkMasks* m);
+void classifyChunk(const unsigned char* p, ChunkMasks* m);
+void tokenizeChunk(Tokenizer* tok, const unsigned char* p, int n, const ChunkMasks* m, IndexTable* table);
+void tokenizeBlock(Tokenizer* tok, const unsigned char* buf, size_t len, IndexTable* table);
+void tokenizeCodepoint(Tokenizer* tok, uint32_t cp, IndexTable* table);
+size_t tokenizeUtf8Scalar(Tokenizer* tok, const unsigned char* buf, size_t i, size_t stop, size_t len, IndexTable* table);
+size_t resumePendingChar(Tokenizer* tok, const unsigned char* buf, size_t len, IndexTable* table);
+void tokenizeBlockUtf8(Tokenizer* tok, const unsigned char* buf, size_t len, IndexTable* table);
+void finishTokenizer(Tokenizer* tok, IndexTable* table);
+void pushTail(TailWindow* tail, const unsigned char* data, size_t n);
+void finishDocState(BinDocState* state, const Tokenizer* tok, uint64_t bytes, const unsigned char* tail, size_t tailLen);
+uint64_t tokenizeStream(FILE* file, Tokenizer* tok, IndexTable* table, TailWindow* tail);
+void processStream(FILE* file, int docId, IndexTable* table);
+void processFile(const char* filename, int docId, IndexTable* table);
+void loadPreviousDocuments(const BinIndex* index);
+int indexAppendedText(IndexTable* delta);
+void entryFromBinTerm(Arena* arena, const BinTerm* term, IndexEntry* entry);
+void mergePostings(Arena* arena, IndexEntry* dst, const IndexEntry* src);
+void mergeWithPreviousIndex(const BinIndex* index, IndexTable* delta, IndexTable* table);
+size_t tableMemory(const IndexTable* table);
+void runFileName(const RunSet* runs, int run, char* name, size_t size);
+void writeRunEntry(FILE* file, const IndexEntry* entry);
+void spillTable(IndexTable* table);
+int readRunEntry(RunReader* reader);
+void mergeRunRange(const RunSet* runs, int first, int count, EntrySink sink, void* context);
+void writeRunSink(void* context, const IndexEntry* entry);
+void writeOutputSink(void* context, const IndexEntry* entry);
+void writeMergedRuns(RunSet* runs, const char* outputFilename, const char* binaryFilename);
+#ifndef _WIN32
+void runThreads(void* (*start)(void*), void* args, size_t argSize, int count);
+int processFileParallel(const char* filename, IndexTable* table, int jobs);
+void mergeShards(IndexShard* shards, int jobs, IndexTable* table);
+int processDocumentsParallel(IndexTable* table, int jobs);
+#endif
+
+void addDocument(const char* path);
+void addDocumentList(const char* listFile);
+void addDocumentDirectory(const char* dirPath);
+void freeDocuments();
+int isDirectory(const char* path);
+void printDocumentList(const char* outputFilename);
+void printIndexTable(const IndexTable* table, const char* outputFilename);
+int openTextWriter(TextWriter* writer, const char* outputFilename);
+void flushTextWriter(TextWriter* writer);
+void closeTextWriter(TextWriter* writer);
+void writeTextEntry(TextWriter* writer, const IndexEntry* entry);
+void appendBytes(unsigned char** buf, size_t* size, size_t* capacity, const void* data, size_t n);
+void writePadding(FILE* file, uint64_t* offset);
+int openBinIndexWriter(BinIndexWriter* writer, const char* outputFilename);
+void addBinIndexEntry(BinIndexWriter* writer, const IndexEntry* entry);
+void closeBinIndexWriter(BinIndexWriter* writer);
+void writeBinaryIndex(const IndexTable* table, const char* outputFilename);
+void printStats(const IndexTable* table);
+void initTermStats(TermStats* stats, size_t budget);
+void countTermPair(TermStats* stats, int docId, int term);
+void freeTermStats(TermStats* stats);
+int termBefore(const void* context, const TopItem* a, const TopItem* b);
+int pairBefore(const void* context, const TopItem* a, const TopItem* b);
+void writeTopTerms(const IndexTable* table, int k, const char* outputFilename);
+void writeTopPairs(const IndexTable* table, int k, const char* outputFilename);
+double peakRssMB(void);
+
+#endif
@@ -2,46 +2,45 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdint.h>
 
-#define MAX_WORD_LEN 100
-#define MAX_STOP_WORDS 500
-#define INITIAL_TABLE_CAP 1000
-#define INITIAL_LINE_STR_CAP 32
-
-typedef struct {
-    char *word;
-    int count;
-    char *lines;
-    int line_capacity;
-    int last_line_added;
-} IndexEntry;
-
-typedef struct {
-    IndexEntry *entries;
-    int count;
-    int capacity;
-} IndexTable;
-
-char* g_stopWords[MAX_STOP_WORDS];
-int g_stopWordsCount = 0;
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <dirent.h>
+#include <sys/stat.h>
 
-int compareStrings(const void* a, const void* b);
-int compareIndexEntries(const void* a, const void* b);
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#endif
 
-void loadStopWords(const char* filename);
-int isStopWord(const char* word);
-void freeStopWords();
+#include "indexer.h"
+#include "unicode.h"
 
-void initIndexTable(IndexTable* table);
-IndexEntry* findWord(IndexTable* table, const char* word);
-IndexEntry* addWord(IndexTable* table, const char* word);
-void addLineToString(IndexEntry* entry, int lineNumber);
-void freeIndexTable(IndexTable* table);
+unsigned char g_charClass[256];
+int g_utf8Mode = 0;     /* -U: tach tu theo chu cai Unicode thay vi tung byte ASCII */
 
-void processFile(const char* filename, IndexTable* table);
-void printIndexTable(const IndexTable* table, const char* outputFilename);
+char** g_documents = NULL;
+BinDocState* g_docStates = NULL;    /* trang thai cuoi cua moi tai lieu, ghi vao chi muc nhi phan */
+int g_documentCount = 0;
+int g_documentCapacity = 0;
+int g_previousDocumentCount = 0;    /* -u: so tai lieu da co trong chi muc cu */
+
+StopWordSlot* g_stopWords = NULL;
+unsigned int g_stopWordsMask = 0;
+int g_stopWordsCount = 0;
+uint64_t g_stopWordLengths = 0;     /* bit i bat neu co tu dung dai i (i < 64); bit 63 cho moi tu dai hon */
 
-int main() {
+#ifndef L1_NO_MAIN
+int main(int argc, char* argv[]) {
     
     const char* stopWordFile = "stopw.txt";
     
@@ -49,33 +48,339 @@ int main() {
     
     const char* outputFile = "output.txt";
 
+    const char* documentListFile = "documents.txt";
+
+    const char* binaryFile = NULL;
+
+    const char* pairFile = "bigram.txt";
+
+    int topK = 0;
+
+    int jobs = 1;
+
+    int stats = 0;
+
+    const char* updateFile = NULL;
+
+    BinIndex previous;
+
+    RunSet runs;
+    memset(&runs, 0, sizeof(runs));
+    runs.prefix = outputFile;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            jobs = atoi(argv[++i]);
+            if (jobs < 1) {
+                jobs = 1;
+            } else if (jobs > MAX_JOBS) {
+                jobs = MAX_JOBS;
+            }
+        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            binaryFile = argv[++i];
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            long megabytes = atol(argv[++i]);
+            if (megabytes < MIN_MEMORY_BUDGET_MB) {
+                megabytes = MIN_MEMORY_BUDGET_MB;
+            }
+            runs.budget = (size_t)megabytes << 20;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            stats = 1;
+        } else if (strcmp(argv[i], "-U") == 0) {
+            g_utf8Mode = 1;
+        } else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
+            topK = atoi(argv[++i]);
+            if (topK < 1) {
+                fprintf(stderr, "Loi: -k can mot so duong\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-u") == 0 && i + 1 < argc) {
+            if (updateFile || g_documentCount > 0) {
+                fprintf(stderr, "Loi: -u phai dung mot lan, truoc danh sach tai lieu\n");
+                return 1;
+            }
+            updateFile = argv[++i];
+            if (!openBinIndex(updateFile, &previous)) {
+                return 1;
+            }
+            loadPreviousDocuments(&previous);
+        } else if (argv[i][0] == '@') {
+            addDocumentList(argv[i] + 1);
+        } else if (isDirectory(argv[i])) {
+            addDocumentDirectory(argv[i]);
+        } else {
+            addDocument(argv[i]);
+        }
+    }
+    if (g_documentCount == 0) {
+        addDocument(inputFile);
+    }
+    if (topK > 0 && (updateFile || binaryFile)) {
+        fprintf(stderr, "Loi: -k khong dung chung voi -u hoac -b\n");
+        return 1;
+    }
+
+    if (updateFile) {
+        /* Phan noi them phai duoc tach tu giong phan da co */
+        g_utf8Mode = (previous.header->flags & BIN_INDEX_UTF8) != 0;
+    }
+
+    initCharClasses();
+    if (g_utf8Mode) {
+        initUnicodeTables();
+    }
     loadStopWords(stopWordFile);
 
     IndexTable table;
     initIndexTable(&table);
 
-    processFile(inputFile, &table);
+    if (topK > 0) {
+        /* Mot lan quet, mot luong: -m la ngan sach cua bo dem cap tu */
+        TermStats termStats;
+        initTermStats(&termStats, runs.budget ? runs.budget : (size_t)DEFAULT_PAIR_BUDGET_MB << 20);
+        table.stats = &termStats;
+        for (int d = 0; d < g_documentCount; d++) {
+            processFile(g_documents[d], d, &table);
+        }
+
+        writeTopTerms(&table, topK, outputFile);
+        writeTopPairs(&table, topK, pairFile);
+        printf("Da xu ly xong. Kiem tra tep '%s' va '%s' de xem ket qua.\n", outputFile, pairFile);
+        if (stats) {
+            printStats(&table);
+        }
+
+        freeTermStats(&termStats);
+        freeIndexTable(&table);
+        freeStopWords();
+        freeDocuments();
+        return 0;
+    }
+
+    int sorted = 0;
+    if (updateFile) {
+        IndexTable delta;
+        initIndexTable(&delta);
+        if (indexAppendedText(&delta)) {
+            sortIndexEntries(delta.entries, delta.count, jobs);
+            mergeWithPreviousIndex(&previous, &delta, &table);
+            sorted = 1;
+        } else {
+            freeIndexTable(&delta);
+        }
+        if (!binaryFile) {
+            binaryFile = updateFile;
+        }
+    }
+#ifndef _WIN32
+    /* -m: lap chi muc tuan tu de cac run noi tiep nhau theo thu tu (tai lieu, dong); -j chi dung de sap xep */
+    if (!sorted && !runs.budget && jobs > 1 && g_documentCount > 1) {
+        sorted = processDocumentsParallel(&table, jobs);
+    } else if (!sorted && !runs.budget && jobs > 1 && strcmp(g_documents[0], "-") != 0) {
+        sorted = processFileParallel(g_documents[0], &table, jobs);
+    }
+#endif
+    if (!sorted) {
+        if (runs.budget) {
+            runs.jobs = jobs;
+            table.runs = &runs;
+        }
+        for (int d = 0; d < g_documentCount; d++) {
+            processFile(g_documents[d], d, &table);
+        }
+
+        if (runs.count > 0) {
+            spillTable(&table);
+        } else {
+            /* Sau khi sap xep, cac chi so trong table.buckets khong con hop le */
+            sortIndexEntries(table.entries, table.count, jobs);
+        }
+    }
 
-    qsort(table.entries, table.count, sizeof(IndexEntry), compareIndexEntries);
+    /* table co the con tro vao chi muc cu dang anh xa, nen ghi ra tep tam roi moi thay the */
+    char tempFile[MAX_PATH_LEN];
+    const char* binaryTarget = binaryFile;
+    if (binaryFile && updateFile) {
+        snprintf(tempFile, sizeof(tempFile), "%s.tmp", binaryFile);
+        binaryTarget = tempFile;
+    }
 
-    printIndexTable(&table, outputFile);
+    if (runs.count > 0) {
+        writeMergedRuns(&runs, outputFile, binaryTarget);
+    } else {
+        printIndexTable(&table, outputFile);
+        if (binaryTarget) {
+            writeBinaryIndex(&table, binaryTarget);
+        }
+    }
+    if (g_documentCount > 1) {
+        printDocumentList(documentListFile);
+    }
+    if (binaryTarget && binaryTarget != binaryFile) {
+#ifdef _WIN32
+        remove(binaryFile);
+#endif
+        if (rename(tempFile, binaryFile) != 0) {
+            perror("Loi thay the tep chi muc nhi phan");
+        }
+    }
     
     printf("Da xu ly xong. Kiem tra tep '%s' de xem ket qua.\n", outputFile);
+    if (stats) {
+        printStats(&table);
+    }
 
     freeIndexTable(&table);
+    if (updateFile) {
+        closeBinIndex(&previous);
+    }
     freeStopWords();
+    freeDocuments();
 
     return 0;
 }
+#endif
 
 int compareStrings(const void* a, const void* b) {
     return strcmp(*(const char**)a, *(const char**)b);
 }
 
-int compareIndexEntries(const void* a, const void* b) {
-    const IndexEntry* entryA = (const IndexEntry*)a;
-    const IndexEntry* entryB = (const IndexEntry*)b;
-    return strcmp(entryA->word, entryB->word);
+static void insertionSortKeys(SortKey* keys, int n, int depth) {
+    for (int i = 1; i < n; i++) {
+        SortKey key = keys[i];
+        int j = i;
+        while (j > 0 && strcmp((const char*)keys[j - 1].word + depth, (const char*)key.word + depth) > 0) {
+            keys[j] = keys[j - 1];
+            j--;
+        }
+        keys[j] = key;
+    }
+}
+
+static void swapKeys(SortKey* keys, int a, int b) {
+    SortKey t = keys[a];
+    keys[a] = keys[b];
+    keys[b] = t;
+}
+
+/*
+ * Multikey quicksort (Bentley-Sedgewick): chia ba phan theo ky tu thu depth, phan bang nhau
+ * chuyen sang ky tu ke tiep nen moi ky tu chi duoc so sanh mot lan o moi tang. So sanh byte
+ * khong dau nen thu tu giong strcmp.
+ */
+static void multikeySort(SortKey* keys, int n, int depth) {
+    while (n > INSERTION_SORT_MAX) {
+        unsigned char a = keys[0].word[depth];
+        unsigned char b = keys[n / 2].word[depth];
+        unsigned char c = keys[n - 1].word[depth];
+        unsigned char pivot = a < b ? (b < c ? b : (a < c ? c : a)) : (a < c ? a : (b < c ? c : b));
+
+        int lt = 0, i = 0, gt = n;
+        while (i < gt) {
+            unsigned char ch = keys[i].word[depth];
+            if (ch < pivot) {
+                swapKeys(keys, lt++, i++);
+            } else if (ch > pivot) {
+                swapKeys(keys, i, --gt);
+            } else {
+                i++;
+            }
+        }
+
+        multikeySort(keys, lt, depth);
+        multikeySort(keys + gt, n - gt, depth);
+        if (pivot == '\0') {
+            return;
+        }
+        keys += lt;
+        n = gt - lt;
+        depth++;
+    }
+    insertionSortKeys(keys, n, depth);
+}
+
+#ifndef _WIN32
+static void* sortBuckets(void* arg) {
+    SortTask* task = (SortTask*)arg;
+    int bucket;
+    while ((bucket = __sync_fetch_and_add(&task->nextBucket, 1)) < 256) {
+        int begin = task->bucketStart[bucket];
+        int n = task->bucketStart[bucket + 1] - begin;
+        if (bucket != 0 && n > 1) {
+            multikeySort(task->keys + begin, n, 1);
+        }
+    }
+    return NULL;
+}
+
+/* Phan phoi theo ky tu dau (MSD radix mot tang) roi sap xep song song tung nhom */
+static void sortKeysParallel(SortKey* keys, int count, int jobs) {
+    if (jobs > MAX_JOBS) {
+        jobs = MAX_JOBS;       /* l1bench -j khong bi gioi han khi doc tham so */
+    }
+    int bucketStart[257] = {0};
+    for (int i = 0; i < count; i++) {
+        bucketStart[keys[i].word[0] + 1]++;
+    }
+    for (int b = 0; b < 256; b++) {
+        bucketStart[b + 1] += bucketStart[b];
+    }
+
+    SortKey* scattered = (SortKey*)malloc(count * sizeof(SortKey));
+    if (!scattered) {
+        perror("Loi cap phat bo nho khi sap xep");
+        exit(1);
+    }
+    int next[256];
+    memcpy(next, bucketStart, sizeof(next));
+    for (int i = 0; i < count; i++) {
+        scattered[next[keys[i].word[0]]++] = keys[i];
+    }
+    memcpy(keys, scattered, count * sizeof(SortKey));
+    free(scattered);
+
+    SortTask task;
+    task.keys = keys;
+    task.bucketStart = bucketStart;
+    task.nextBucket = 0;
+    /* Moi luong lay nhom chua ai nhan; luong khong tao duoc thi luong goi tu sap cac nhom con lai */
+    runThreads(sortBuckets, &task, 0, jobs);
+}
+#endif
+
+/* Sap xep entries theo word, dung thu tu cua strcmp */
+void sortIndexEntries(IndexEntry* entries, int count, int jobs) {
+    if (count < 2) {
+        return;
+    }
+
+    SortKey* keys = (SortKey*)malloc(count * sizeof(SortKey));
+    IndexEntry* sorted = (IndexEntry*)malloc(count * sizeof(IndexEntry));
+    if (!keys || !sorted) {
+        perror("Loi cap phat bo nho khi sap xep");
+        exit(1);
+    }
+    for (int i = 0; i < count; i++) {
+        keys[i].word = (const unsigned char*)entries[i].word;
+        keys[i].index = i;
+    }
+
+#ifndef _WIN32
+    if (jobs > 1 && count >= PARALLEL_SORT_MIN) {
+        sortKeysParallel(keys, count, jobs);
+    } else {
+        multikeySort(keys, count, 0);
+    }
+#else
+    multikeySort(keys, count, 0);
+#endif
+
+    for (int i = 0; i < count; i++) {
+        sorted[i] = entries[keys[i].index];
+    }
+    memcpy(entries, sorted, count * sizeof(IndexEntry));
+    free(sorted);
+    free(keys);
 }
 
 void loadStopWords(const char* filename) {
@@ -86,28 +391,202 @@ void loadStopWords(const char* filename) {
     }
 
     char buffer[MAX_WORD_LEN];
-    while (g_stopWordsCount < MAX_STOP_WORDS && fgets(buffer, sizeof(buffer), file)) {
+    while (fgets(buffer, sizeof(buffer), file)) {
         buffer[strcspn(buffer, "\n")] = 0;
-        if (strlen(buffer) > 0) {
-            for (int i = 0; buffer[i]; i++) {
-                buffer[i] = tolower(buffer[i]);
+        int length = 0;
+        if (g_utf8Mode) {
+            char folded[MAX_WORD_LEN];
+            length = (int)foldUtf8Word(folded, sizeof(folded), buffer, strlen(buffer));
+            memcpy(buffer, folded, length + 1);
+        } else {
+            for (; buffer[length]; length++) {
+                buffer[length] = tolower(buffer[length]);
             }
-            g_stopWords[g_stopWordsCount++] = strdup(buffer);
+        }
+        if (length > 0) {
+            addStopWord(buffer, length);
         }
     }
     fclose(file);
+}
+
+static uint64_t stopLengthBit(int length) {
+    return (uint64_t)1 << (length < 63 ? length : 63);
+}
+
+void addStopWord(const char* word, int length) {
+    if (2 * (g_stopWordsCount + 1) > (int)(g_stopWordsMask + 1)) {
+        growStopWords();
+    }
 
-    qsort(g_stopWords, g_stopWordsCount, sizeof(char*), compareStrings);
+    unsigned int h = hashWord(word);
+    unsigned int slot = h & g_stopWordsMask;
+    while (g_stopWords[slot].word) {
+        if (g_stopWords[slot].hash == h && strcmp(g_stopWords[slot].word, word) == 0) {
+            return;
+        }
+        slot = (slot + 1) & g_stopWordsMask;
+    }
+
+    g_stopWords[slot].word = strdup(word);
+    if (!g_stopWords[slot].word) {
+        perror("Loi cap phat bo nho cho tu dung");
+        exit(1);
+    }
+    g_stopWords[slot].hash = h;
+    g_stopWordsCount++;
+    g_stopWordLengths |= stopLengthBit(length);
+}
+
+/* Nhan doi bang tu dung va chen lai theo hash da luu */
+void growStopWords(void) {
+    unsigned int oldCount = g_stopWords ? g_stopWordsMask + 1 : 0;
+    unsigned int newCount = oldCount ? oldCount * 2 : INITIAL_STOP_CAP;
+    StopWordSlot* newSlots = (StopWordSlot*)calloc(newCount, sizeof(StopWordSlot));
+    if (!newSlots) {
+        perror("Loi cap phat bo nho cho bang tu dung");
+        exit(1);
+    }
+
+    unsigned int mask = newCount - 1;
+    for (unsigned int i = 0; i < oldCount; i++) {
+        if (g_stopWords[i].word) {
+            unsigned int slot = g_stopWords[i].hash & mask;
+            while (newSlots[slot].word) {
+                slot = (slot + 1) & mask;
+            }
+            newSlots[slot] = g_stopWords[i];
+        }
+    }
+
+    free(g_stopWords);
+    g_stopWords = newSlots;
+    g_stopWordsMask = mask;
 }
 
-int isStopWord(const char* word) {
-    return bsearch(&word, g_stopWords, g_stopWordsCount, sizeof(char*), compareStrings) != NULL;
+/* Duoc goi cho moi tu: loc theo do dai truoc, roi tra bang bam (trung binh duoi hai lan so sanh) */
+int isStopWord(const char* word, int length) {
+    if (!(g_stopWordLengths & stopLengthBit(length))) {
+        return 0;
+    }
+
+    unsigned int h = hashWord(word);
+    unsigned int slot = h & g_stopWordsMask;
+    while (g_stopWords[slot].word) {
+        if (g_stopWords[slot].hash == h && strcmp(g_stopWords[slot].word, word) == 0) {
+            return 1;
+        }
+        slot = (slot + 1) & g_stopWordsMask;
+    }
+    return 0;
 }
 
 void freeStopWords() {
-    for (int i = 0; i < g_stopWordsCount; i++) {
-        free(g_stopWords[i]);
+    for (unsigned int i = 0; g_stopWords && i <= g_stopWordsMask; i++) {
+        free(g_stopWords[i].word);
+    }
+    free(g_stopWords);
+    g_stopWords = NULL;
+    g_stopWordsCount = 0;
+}
+
+void addDocument(const char* path) {
+    /* -u: tai lieu da co trong chi muc cu chi duoc doc tiep phan noi them */
+    for (int i = 0; i < g_previousDocumentCount; i++) {
+        if (strcmp(g_documents[i], path) == 0) {
+            return;
+        }
+    }
+
+    if (g_documentCount == g_documentCapacity) {
+        g_documentCapacity = g_documentCapacity ? g_documentCapacity * 2 : INITIAL_DOC_CAP;
+        g_documents = (char**)realloc(g_documents, g_documentCapacity * sizeof(char*));
+        g_docStates = (BinDocState*)realloc(g_docStates, g_documentCapacity * sizeof(BinDocState));
+        if (!g_documents || !g_docStates) {
+            perror("Loi cap phat bo nho cho danh sach tai lieu");
+            exit(1);
+        }
+    }
+
+    BinDocState* state = &g_docStates[g_documentCount];
+    memset(state, 0, sizeof(BinDocState));
+    state->lastLine = 1;
+    state->flags = BIN_DOC_AFTER_PUNCT;
+    state->tailHash = binTailHash(NULL, 0);
+    g_documents[g_documentCount++] = strdup(path);
+}
+
+/* Moi dong cua listFile la duong dan mot tai lieu */
+void addDocumentList(const char* listFile) {
+    FILE* file = fopen(listFile, "r");
+    if (!file) {
+        fprintf(stderr, "Loi: Khong mo duoc danh sach tai lieu %s\n", listFile);
+        exit(1);
+    }
+
+    char buffer[MAX_PATH_LEN];
+    while (fgets(buffer, sizeof(buffer), file)) {
+        buffer[strcspn(buffer, "\r\n")] = 0;
+        if (strlen(buffer) > 0) {
+            addDocument(buffer);
+        }
+    }
+    fclose(file);
+}
+
+int isDirectory(const char* path) {
+    struct stat st;
+    return stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+/* Them moi tep thuong trong thu muc (de quy), theo thu tu ten de docId on dinh giua cac lan chay */
+void addDocumentDirectory(const char* dirPath) {
+    DIR* dir = opendir(dirPath);
+    if (!dir) {
+        fprintf(stderr, "Loi: Khong mo duoc thu muc %s\n", dirPath);
+        exit(1);
+    }
+
+    char** names = NULL;
+    int count = 0, capacity = 0;
+    struct dirent* ent;
+    while ((ent = readdir(dir)) != NULL) {
+        if (ent->d_name[0] == '.') {
+            continue;
+        }
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : INITIAL_DOC_CAP;
+            names = (char**)realloc(names, capacity * sizeof(char*));
+            if (!names) {
+                perror("Loi cap phat bo nho cho danh sach tai lieu");
+                exit(1);
+            }
+        }
+        names[count++] = strdup(ent->d_name);
+    }
+    closedir(dir);
+
+    qsort(names, count, sizeof(char*), compareStrings);
+
+    char path[MAX_PATH_LEN];
+    for (int i = 0; i < count; i++) {
+        snprintf(path, sizeof(path), "%s/%s", dirPath, names[i]);
+        if (isDirectory(path)) {
+            addDocumentDirectory(path);
+        } else {
+            addDocument(path);
+        }
+        free(names[i]);
+    }
+    free(names);
+}
+
+void freeDocuments() {
+    for (int i = 0; i < g_documentCount; i++) {
+        free(g_documents[i]);
     }
+    free(g_documents);
+    free(g_docStates);
 }
 
 void initIndexTable(IndexTable* table) {
@@ -118,13 +597,69 @@ void initIndexTable(IndexTable* table) {
     }
     table->count = 0;
     table->capacity = INITIAL_TABLE_CAP;
+
+    initArena(&table->arena);
+    table->runs = NULL;
+    table->stats = NULL;
+
+    table->bucketCount = INITIAL_HASH_CAP;
+    table->buckets = (int*)malloc(table->bucketCount * sizeof(int));
+    if (!table->buckets) {
+        perror("Loi cap phat bo nho cho bang bam");
+        exit(1);
+    }
+    for (int i = 0; i < table->bucketCount; i++) {
+        table->buckets[i] = HASH_EMPTY;
+    }
 }
 
-IndexEntry* findWord(IndexTable* table, const char* word) {
+/* FNV-1a 32 bit */
+unsigned int hashWord(const char* word) {
+    unsigned int h = 2166136261u;
+    while (*word) {
+        h ^= (unsigned char)*word++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/* Nhan doi so o bam va chen lai cac chi so; hash da luu san trong entry nen khong phai bam lai chuoi */
+void growHashIndex(IndexTable* table) {
+    int newCount = table->bucketCount * 2;
+    int* newBuckets = (int*)malloc(newCount * sizeof(int));
+    if (!newBuckets) {
+        perror("Loi cap phat lai bo nho cho bang bam");
+        exit(1);
+    }
+    for (int i = 0; i < newCount; i++) {
+        newBuckets[i] = HASH_EMPTY;
+    }
+
+    unsigned int mask = newCount - 1;
     for (int i = 0; i < table->count; i++) {
-        if (strcmp(table->entries[i].word, word) == 0) {
-            return &table->entries[i];
+        unsigned int slot = table->entries[i].hash & mask;
+        while (newBuckets[slot] != HASH_EMPTY) {
+            slot = (slot + 1) & mask;
+        }
+        newBuckets[slot] = i;
+    }
+
+    free(table->buckets);
+    table->buckets = newBuckets;
+    table->bucketCount = newCount;
+}
+
+IndexEntry* findWord(IndexTable* table, const char* word) {
+    unsigned int h = hashWord(word);
+    unsigned int mask = table->bucketCount - 1;
+    unsigned int slot = h & mask;
+
+    while (table->buckets[slot] != HASH_EMPTY) {
+        IndexEntry* entry = &table->entries[table->buckets[slot]];
+        if (entry->hash == h && strcmp(entry->word, word) == 0) {
+            return entry;
         }
+        slot = (slot + 1) & mask;
     }
     return NULL;
 }
@@ -139,137 +674,1780 @@ IndexEntry* addWord(IndexTable* table, const char* word) {
         }
     }
 
+    /* Giu he so tai <= 1/2 de chuoi do tuyen tinh ngan */
+    if ((table->count + 1) * 2 > table->bucketCount) {
+        growHashIndex(table);
+    }
+
     IndexEntry* newEntry = &table->entries[table->count];
-    newEntry->word = strdup(word);
+    newEntry->word = arenaStrdup(&table->arena, word);
+    newEntry->hash = hashWord(word);
     newEntry->count = 0;
-    newEntry->line_capacity = INITIAL_LINE_STR_CAP;
-    newEntry->lines = (char*)malloc(newEntry->line_capacity);
-    newEntry->lines[0] = '\0';
-    newEntry->last_line_added = -1;
+    newEntry->posting_capacity = INITIAL_POSTING_CAP;
+    newEntry->posting_size = 0;
+    newEntry->postings = (unsigned char*)arenaAlloc(&table->arena, newEntry->posting_capacity);
+    newEntry->last_doc_added = 0;
+    newEntry->last_line_added = 0;
+
+    unsigned int mask = table->bucketCount - 1;
+    unsigned int slot = newEntry->hash & mask;
+    while (table->buckets[slot] != HASH_EMPTY) {
+        slot = (slot + 1) & mask;
+    }
+    table->buckets[slot] = table->count;
 
     table->count++;
     return newEntry;
 }
 
-void addLineToString(IndexEntry* entry, int lineNumber) {
-    if (entry->last_line_added == lineNumber) {
+/* Dung luong luon la luy thua 2 nen vung cu duoc arena dung lai cho entry khac */
+void reservePostings(Arena* arena, IndexEntry* entry, int extra) {
+    if (entry->posting_size + extra > entry->posting_capacity) {
+        int oldCapacity = entry->posting_capacity;
+        while (entry->posting_size + extra > entry->posting_capacity) {
+            entry->posting_capacity *= 2;
+        }
+        entry->postings = (unsigned char*)arenaRealloc(arena, entry->postings, oldCapacity,
+                                                       entry->posting_capacity);
+    }
+}
+
+void addLinePosting(Arena* arena, IndexEntry* entry, int docId, int lineNumber) {
+    if (entry->last_doc_added == docId && entry->last_line_added == lineNumber) {
         return;
     }
 
-    char line_buffer[16];
-    sprintf(line_buffer, ",%d", lineNumber);
+    reservePostings(arena, entry, 3 * MAX_VARINT_LEN);
+    entry->posting_size += encodePosting(entry->postings + entry->posting_size,
+                                         entry->last_doc_added, entry->last_line_added,
+                                         docId, lineNumber);
+    entry->last_doc_added = docId;
+    entry->last_line_added = lineNumber;
+}
+
+/* Noi danh sach cua src (cac cap deu lon hon cua dst) vao cuoi dst; chi cap dau phai ma hoa lai */
+void appendPostings(Arena* arena, IndexEntry* dst, const IndexEntry* src) {
+    int firstDoc = 0, firstLine = 0;
+    int head = decodePosting(src->postings, &firstDoc, &firstLine);
+    int rest = src->posting_size - head;
+
+    reservePostings(arena, dst, 3 * MAX_VARINT_LEN + rest);
+    dst->posting_size += encodePosting(dst->postings + dst->posting_size,
+                                       dst->last_doc_added, dst->last_line_added,
+                                       firstDoc, firstLine);
+    memcpy(dst->postings + dst->posting_size, src->postings + head, rest);
+    dst->posting_size += rest;
+    dst->count += src->count;
+    dst->last_doc_added = src->last_doc_added;
+    dst->last_line_added = src->last_line_added;
+}
+
+void freeIndexTable(IndexTable* table) {
+    freeArena(&table->arena);
+    free(table->entries);
+    free(table->buckets);
+}
+
+void initTokenizer(Tokenizer* tok) {
+    tok->wordIndex = 0;
+    tok->docId = 0;
+    tok->lineNumber = 1;
+    tok->afterPunctuation = 1;
+    tok->tokens = NULL;
+    tok->pendingLength = 0;
+}
+
+/* firstChar la byte ASCII, hoac ma Unicode khi -U */
+static inline int isUpperFirst(int c) {
+    return c < 0x80 ? isupper(c) : isUnicodeUpper((uint32_t)c);
+}
+
+void initTokenList(TokenList* list) {
+    memset(list, 0, sizeof(*list));
+}
 
-    int needed_capacity = strlen(entry->lines) + strlen(line_buffer) + 1;
-    if (needed_capacity > entry->line_capacity) {
-        while (needed_capacity > entry->line_capacity) {
-            entry->line_capacity *= 2;
+void appendToken(TokenList* list, const Tokenizer* tok) {
+    if (list->count == list->capacity) {
+        int newCapacity = list->capacity ? list->capacity * 2 : INITIAL_TABLE_CAP;
+        Token* grown = realloc(list->tokens, newCapacity * sizeof(Token));
+        if (!grown) {
+            perror("Loi cap phat danh sach tu");
+            exit(1);
         }
-        entry->lines = (char*)realloc(entry->lines, entry->line_capacity);
-        if (!entry->lines) {
-            perror("Loi cap phat lai bo nho cho chuoi dong");
+        list->tokens = grown;
+        list->capacity = newCapacity;
+    }
+    if (list->textSize + tok->wordIndex + 1 > list->textCapacity) {
+        size_t newCapacity = list->textCapacity ? list->textCapacity * 2 : READ_BLOCK_SIZE;
+        char* grown = realloc(list->text, newCapacity);
+        if (!grown) {
+            perror("Loi cap phat danh sach tu");
             exit(1);
         }
+        list->text = grown;
+        list->textCapacity = newCapacity;
     }
 
-    strcat(entry->lines, line_buffer);
-    entry->last_line_added = lineNumber;
+    Token* token = &list->tokens[list->count++];
+    token->offset = list->textSize;
+    token->lineNumber = tok->lineNumber;
+    token->length = (unsigned char)tok->wordIndex;
+    token->proper = isUpperFirst(tok->firstChar) && !tok->afterPunctuation;
+    memcpy(list->text + list->textSize, tok->lowercaseWord, tok->wordIndex + 1);
+    list->textSize += tok->wordIndex + 1;
 }
 
-void freeIndexTable(IndexTable* table) {
-    for (int i = 0; i < table->count; i++) {
-        free(table->entries[i].word);
-        free(table->entries[i].lines);
-    }
-    free(table->entries);
+void freeTokenList(TokenList* list) {
+    free(list->tokens);
+    free(list->text);
+    initTokenList(list);
 }
 
-void processFile(const char* filename, IndexTable* table) {
-    FILE* file = fopen(filename, "r");
-    if (!file) {
-        fprintf(stderr, "Loi: Khong mo duoc tep van ban: %s\n", filename);
-        exit(1);
+void flushWord(Tokenizer* tok, IndexTable* table) {
+    tok->lowercaseWord[tok->wordIndex] = '\0';
+
+    if (tok->tokens) {
+        appendToken(tok->tokens, tok);
+        tok->wordIndex = 0;
+        return;
     }
 
-    char originalWord[MAX_WORD_LEN];
-    char lowercaseWord[MAX_WORD_LEN];
-    int wordIndex = 0;
-    int lineNumber = 1;
-    int afterPunctuation = 1;
+    int isProper = isUpperFirst(tok->firstChar) && !tok->afterPunctuation;
+    int isStop = isStopWord(tok->lowercaseWord, tok->wordIndex);
 
-    int c;
-    while ((c = fgetc(file)) != EOF) {
-        if (isalpha(c)) {
-            if (wordIndex < MAX_WORD_LEN - 1) {
-                originalWord[wordIndex] = c;
-                lowercaseWord[wordIndex] = tolower(c);
-                wordIndex++;
+    if (!isProper && !isStop) {
+        IndexEntry* entry = findWord(table, tok->lowercaseWord);
+        if (entry == NULL) {
+            entry = addWord(table, tok->lowercaseWord);
+        }
+
+        entry->count++;
+        if (table->stats) {
+            countTermPair(table->stats, tok->docId, (int)(entry - table->entries));
+        } else {
+            addLinePosting(&table->arena, entry, tok->docId, tok->lineNumber);
+
+            if (table->runs && tableMemory(table) > table->runs->budget) {
+                spillTable(table);
             }
         }
-        else {
-            if (wordIndex > 0) {
-                originalWord[wordIndex] = '\0';
-                lowercaseWord[wordIndex] = '\0';
+    } else if (table->stats) {
+        table->stats->previousTerm = -1;
+    }
+
+    tok->wordIndex = 0;
+}
+
+void initCharClasses(void) {
+    for (int c = 0; c < 256; c++) {
+        unsigned char cls = 0;
+        if (isalpha(c)) {
+            cls = CLS_ALPHA;
+        } else if (c == '\n') {
+            cls = CLS_NEWLINE;
+        } else if (c == '.' || c == '?' || c == '!') {
+            cls = CLS_SENTENCE;
+        } else if (isspace(c)) {
+            cls = CLS_BLANK;
+        }
+        g_charClass[c] = cls;
+    }
+}
+
+void classifyScalar(const unsigned char* p, int n, ChunkMasks* m) {
+    m->alpha = m->newline = m->sentence = m->blank = 0;
+    for (int i = 0; i < n; i++) {
+        uint32_t bit = (uint32_t)1 << i;
+        unsigned char cls = g_charClass[p[i]];
+        if (cls & CLS_ALPHA) m->alpha |= bit;
+        if (cls & CLS_NEWLINE) m->newline |= bit;
+        if (cls & CLS_SENTENCE) m->sentence |= bit;
+        if (cls & CLS_BLANK) m->blank |= bit;
+    }
+}
 
-                int isProper = isupper(originalWord[0]) && !afterPunctuation;
-                int isStop = isStopWord(lowercaseWord);
+#if defined(__AVX2__)
+void classifyChunk(const unsigned char* p, ChunkMasks* m) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)p);
+    /* (c | 0x20) trong 'a'..'z' <=> c la chu cai ASCII; dich ve bien -128 de so sanh co dau */
+    __m256i folded = _mm256_add_epi8(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), _mm256_set1_epi8((char)(128 - 'a')));
+    __m256i alpha = _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(-128 + 26)), folded);
+    __m256i nl = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'));
+    __m256i sentence = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('.')),
+                       _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('?')),
+                                       _mm256_cmpeq_epi8(v, _mm256_set1_epi8('!'))));
+    /* '\t'..'\r' hoac ' ' */
+    __m256i ctl = _mm256_add_epi8(v, _mm256_set1_epi8((char)(128 - '\t')));
+    __m256i space = _mm256_or_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8((char)(-128 + 5)), ctl),
+                                    _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')));
+    m->alpha = (uint32_t)_mm256_movemask_epi8(alpha);
+    m->newline = (uint32_t)_mm256_movemask_epi8(nl);
+    m->sentence = (uint32_t)_mm256_movemask_epi8(sentence);
+    m->blank = (uint32_t)_mm256_movemask_epi8(space) & ~m->newline;
+}
+#elif defined(__SSE2__)
+void classifyChunk(const unsigned char* p, ChunkMasks* m) {
+    m->alpha = m->newline = m->sentence = m->blank = 0;
+    for (int half = 0; half < 2; half++) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(p + half * 16));
+        __m128i folded = _mm_add_epi8(_mm_or_si128(v, _mm_set1_epi8(0x20)), _mm_set1_epi8((char)(128 - 'a')));
+        __m128i alpha = _mm_cmplt_epi8(folded, _mm_set1_epi8((char)(-128 + 26)));
+        __m128i nl = _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'));
+        __m128i sentence = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('.')),
+                           _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('?')),
+                                        _mm_cmpeq_epi8(v, _mm_set1_epi8('!'))));
+        __m128i ctl = _mm_add_epi8(v, _mm_set1_epi8((char)(128 - '\t')));
+        __m128i space = _mm_or_si128(_mm_cmplt_epi8(ctl, _mm_set1_epi8((char)(-128 + 5))),
+                                     _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+        int shift = half * 16;
+        uint32_t nlBits = (uint32_t)_mm_movemask_epi8(nl);
+        m->alpha |= (uint32_t)_mm_movemask_epi8(alpha) << shift;
+        m->newline |= nlBits << shift;
+        m->sentence |= (uint32_t)_mm_movemask_epi8(sentence) << shift;
+        m->blank |= ((uint32_t)_mm_movemask_epi8(space) & ~nlBits) << shift;
+    }
+}
+#else
+void classifyChunk(const unsigned char* p, ChunkMasks* m) {
+    classifyScalar(p, CHUNK_SIZE, m);
+}
+#endif
 
-                if (!isProper && !isStop) {
-                    IndexEntry* entry = findWord(table, lowercaseWord);
-                    if (entry == NULL) {
-                        entry = addWord(table, lowercaseWord);
+/* Bit i cua ket qua = 1 voi moi i trong [from, to) */
+static inline uint32_t rangeMask(int from, int to) {
+    uint32_t upper = to >= CHUNK_SIZE ? 0xFFFFFFFFu : (((uint32_t)1 << to) - 1);
+    return upper & ~(((uint32_t)1 << from) - 1);
+}
+
+/*
+ * Chay may trang thai cua processFile tren mat na cua mot khoi <= 32 byte:
+ * ranh gioi tu lay bang ctz tren mat na chu cai, so dong bang popcount tren mat na '\n',
+ * va afterPunctuation chi phu thuoc ky tu khong trang cuoi cung trong khoang giua hai tu.
+ */
+void tokenizeChunk(Tokenizer* tok, const unsigned char* p, int n, const ChunkMasks* m, IndexTable* table) {
+    uint32_t valid = rangeMask(0, n);
+    uint32_t nonAlpha = ~m->alpha & valid;
+    uint32_t significant = ~m->alpha & ~m->blank & valid;
+    uint32_t setsPunct = m->newline | m->sentence;
+    int pos = 0;
+
+    while (pos < n) {
+        uint32_t ahead = ~rangeMask(0, pos);
+        if (m->alpha & ((uint32_t)1 << pos)) {
+            uint32_t stop = nonAlpha & ahead;
+            int end = stop ? __builtin_ctz(stop) : n;
+            for (int i = pos; i < end; i++) {
+                if (tok->wordIndex < MAX_WORD_LEN - 1) {
+                    if (tok->wordIndex == 0) {
+                        tok->firstChar = p[i];
                     }
-                    
-                    entry->count++;
-                    addLineToString(entry, lineNumber);
+                    tok->lowercaseWord[tok->wordIndex++] = (char)(p[i] | 0x20);
                 }
-
-                wordIndex = 0;
-                afterPunctuation = 0;
             }
-
-            if (c == '.' || c == '?' || c == '!') {
-                afterPunctuation = 1;
-            } else if (c == '\n') {
-                lineNumber++;
-                afterPunctuation = 1;
-            } else if (isspace(c)) {
-                
-            } else {
-                afterPunctuation = 0;
+            if (end < n) {
+                flushWord(tok, table);
+                tok->afterPunctuation = 0;
+            }
+            pos = end;
+        } else {
+            /* Tu ket thuc dung o bien khoi truoc */
+            if (tok->wordIndex > 0) {
+                flushWord(tok, table);
+                tok->afterPunctuation = 0;
+            }
+            uint32_t next = m->alpha & ahead & valid;
+            int end = next ? __builtin_ctz(next) : n;
+            uint32_t gap = rangeMask(pos, end);
+            tok->lineNumber += __builtin_popcount(m->newline & gap);
+            uint32_t sig = significant & gap;
+            if (sig) {
+                int last = 31 - __builtin_clz(sig);
+                tok->afterPunctuation = (setsPunct >> last) & 1;
             }
+            pos = end;
         }
     }
+}
 
-    if (wordIndex > 0) {
-        originalWord[wordIndex] = '\0';
-        lowercaseWord[wordIndex] = '\0';
-        int isProper = isupper(originalWord[0]) && !afterPunctuation;
-        int isStop = isStopWord(lowercaseWord);
-        if (!isProper && !isStop) {
-            IndexEntry* entry = findWord(table, lowercaseWord);
-            if (entry == NULL) {
-                entry = addWord(table, lowercaseWord);
-            }
-            entry->count++;
-            addLineToString(entry, lineNumber);
-        }
+/* Quet mot khoi byte; trang thai tu dang do duoc giu trong tok nen co the goi lien tiep cho tung khoi */
+void tokenizeBlock(Tokenizer* tok, const unsigned char* buf, size_t len, IndexTable* table) {
+    if (g_utf8Mode) {
+        tokenizeBlockUtf8(tok, buf, len, table);
+        return;
     }
 
-    fclose(file);
+    ChunkMasks m;
+    size_t i = 0;
+
+    for (; i + CHUNK_SIZE <= len; i += CHUNK_SIZE) {
+        classifyChunk(buf + i, &m);
+        tokenizeChunk(tok, buf + i, CHUNK_SIZE, &m, table);
+    }
+
+    if (i < len) {
+        classifyScalar(buf + i, (int)(len - i), &m);
+        tokenizeChunk(tok, buf + i, (int)(len - i), &m, table);
+    }
 }
 
-void printIndexTable(const IndexTable* table, const char* outputFilename) {
-    FILE* file = fopen(outputFilename, "w");
-    if (!file) {
-        fprintf(stderr, "Loi: Khong the mo tep dau ra %s\n", outputFilename);
-        return;
+/* Bit i bat neu byte p[i] >= 0x80 (khong phai ASCII) */
+static inline uint32_t highByteMask(const unsigned char* p) {
+#if defined(__AVX2__)
+    return (uint32_t)_mm256_movemask_epi8(_mm256_loadu_si256((const __m256i*)p));
+#elif defined(__SSE2__)
+    return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)p)) |
+           ((uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(p + 16))) << 16);
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < CHUNK_SIZE; i++) {
+        mask |= (uint32_t)(p[i] >> 7) << i;
     }
+    return mask;
+#endif
+}
 
-    for (int i = 0; i < table->count; i++) {
-        const IndexEntry* entry = &table->entries[i];
-        
-        fprintf(file, "%s %d%s\n", entry->word, entry->count, entry->lines);
+/* Mot ky tu cua che do UTF-8, cung quy tac voi tokenizeChunk: chu cai duoc doi chu thuong va noi vao tu */
+void tokenizeCodepoint(Tokenizer* tok, uint32_t cp, IndexTable* table) {
+    unsigned char cls;
+    if (cp < 0x80) {
+        cls = g_charClass[cp];
+    } else {
+        switch (unicodeClass(cp)) {
+        case UNI_LETTER: cls = CLS_ALPHA; break;
+        case UNI_SPACE: cls = CLS_BLANK; break;
+        case UNI_SENTENCE: cls = CLS_SENTENCE; break;
+        default: cls = 0; break;
+        }
     }
 
-    fclose(file);
-}
\ No newline at end of file
+    if (cls & CLS_ALPHA) {
+        unsigned char bytes[4];
+        int n = encodeUtf8(foldCase(cp), bytes);
+        if (tok->wordIndex + n <= MAX_WORD_LEN - 1) {
+            if (tok->wordIndex == 0) {
+                tok->firstChar = (int)cp;
+            }
+            memcpy(tok->lowercaseWord + tok->wordIndex, bytes, n);
+            tok->wordIndex += n;
+        }
+        return;
+    }
+
+    if (tok->wordIndex > 0) {
+        flushWord(tok, table);
+        tok->afterPunctuation = 0;
+    }
+    if (cls & CLS_NEWLINE) {
+        tok->lineNumber++;
+        tok->afterPunctuation = 1;
+    } else if (cls & CLS_SENTENCE) {
+        tok->afterPunctuation = 1;
+    } else if (!(cls & CLS_BLANK)) {
+        tok->afterPunctuation = 0;
+    }
+}
+
+/*
+ * Giai ma tung ky tu bat dau trong [i, stop); ky tu cuoi co the keo dai qua stop (toi da len).
+ * Ky tu bi cat o cuoi buf duoc giu lai trong tok->pending. Tra ve vi tri tiep theo.
+ */
+size_t tokenizeUtf8Scalar(Tokenizer* tok, const unsigned char* buf, size_t i, size_t stop, size_t len, IndexTable* table) {
+    while (i < stop) {
+        uint32_t cp;
+        int n = decodeUtf8(buf + i, len - i, &cp);
+        if (n == 0) {
+            tok->pendingLength = (int)(len - i);
+            memcpy(tok->pending, buf + i, len - i);
+            return len;
+        }
+        if (n < 0) {
+            cp = UNI_REPLACEMENT;
+            n = 1;
+        }
+        tokenizeCodepoint(tok, cp, table);
+        i += n;
+    }
+    return i;
+}
+
+/* Noi ky tu dang do voi toi da 3 byte dau cua buf; tra ve so byte cua buf da dung */
+size_t resumePendingChar(Tokenizer* tok, const unsigned char* buf, size_t len, IndexTable* table) {
+    unsigned char joined[8];
+    int old = tok->pendingLength;
+    size_t extra = len < 3 ? len : 3;
+
+    memcpy(joined, tok->pending, old);
+    memcpy(joined + old, buf, extra);
+    tok->pendingLength = 0;
+
+    size_t end = tokenizeUtf8Scalar(tok, joined, 0, old, old + extra, table);
+    if (tok->pendingLength > 0) {
+        /* buf qua ngan, van chua du byte: toan bo buf nam trong pending */
+        return len;
+    }
+    return end - old;
+}
+
+/*
+ * -U: khoi 32 byte toan ASCII van di qua classifyChunk/tokenizeChunk; gap byte >= 0x80 thi
+ * phan ASCII phia truoc di duong nhanh, phan con lai cua khoi duoc giai ma tung ky tu.
+ */
+void tokenizeBlockUtf8(Tokenizer* tok, const unsigned char* buf, size_t len, IndexTable* table) {
+    ChunkMasks m;
+    size_t i = 0;
+
+    if (tok->pendingLength > 0) {
+        i = resumePendingChar(tok, buf, len, table);
+    }
+
+    while (i + CHUNK_SIZE <= len) {
+        uint32_t high = highByteMask(buf + i);
+        if (!high) {
+            classifyChunk(buf + i, &m);
+            tokenizeChunk(tok, buf + i, CHUNK_SIZE, &m, table);
+            i += CHUNK_SIZE;
+            continue;
+        }
+
+        int ascii = __builtin_ctz(high);
+        if (ascii > 0) {
+            classifyChunk(buf + i, &m);
+            tokenizeChunk(tok, buf + i, ascii, &m, table);
+        }
+        i = tokenizeUtf8Scalar(tok, buf, i + ascii, i + CHUNK_SIZE, len, table);
+    }
+
+    if (i < len) {
+        tokenizeUtf8Scalar(tok, buf, i, len, len, table);
+    }
+}
+
+void finishTokenizer(Tokenizer* tok, IndexTable* table) {
+    if (tok->pendingLength > 0) {
+        /* Tep ket thuc giua mot ky tu UTF-8: coi nhu byte khong hop le */
+        tok->pendingLength = 0;
+        tokenizeCodepoint(tok, UNI_REPLACEMENT, table);
+    }
+    if (tok->wordIndex > 0) {
+        flushWord(tok, table);
+    }
+}
+
+#ifndef _WIN32
+/* Anh xa ca tep thuong vao bo nho; tra ve NULL neu khong phai tep thuong hoac mmap loi */
+const unsigned char* mapFile(int fd, size_t* size) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        return NULL;
+    }
+
+    *size = (size_t)st.st_size;
+    if (*size == 0) {
+        return (const unsigned char*)"";
+    }
+
+    void* data = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        return NULL;
+    }
+    madvise(data, *size, MADV_SEQUENTIAL);
+    return (const unsigned char*)data;
+}
+
+void unmapFile(const unsigned char* data, size_t size) {
+    if (size > 0) {
+        munmap((void*)data, size);
+    }
+}
+
+int processMappedFile(int fd, int docId, IndexTable* table) {
+    size_t size;
+    const unsigned char* data = mapFile(fd, &size);
+    if (!data) {
+        return 0;
+    }
+
+    Tokenizer tok;
+    initTokenizer(&tok);
+    tok.docId = docId;
+    tokenizeBlock(&tok, data, size, table);
+    finishTokenizer(&tok, table);
+
+    size_t tailLen = size < BIN_TAIL_LEN ? size : BIN_TAIL_LEN;
+    finishDocState(&g_docStates[docId], &tok, size, data + size - tailLen, tailLen);
+
+    unmapFile(data, size);
+    return 1;
+}
+
+/*
+ * Chay start tren count luong, luong t nhan args + t * argSize (argSize = 0: moi luong cung args).
+ * Neu pthread_create loi (het bo nho, gioi han luong), cac phan viec con lai chay ngay tren luong goi,
+ * nen ket qua khong doi, chi cham hon.
+ */
+void runThreads(void* (*start)(void*), void* args, size_t argSize, int count) {
+    pthread_t* threads = (pthread_t*)malloc(count * sizeof(pthread_t));
+    if (!threads) {
+        perror("Loi cap phat bo nho cho cac luong");
+        exit(1);
+    }
+
+    int started = 0;
+    while (started < count &&
+           pthread_create(&threads[started], NULL, start, (char*)args + started * argSize) == 0) {
+        started++;
+    }
+    if (started < count) {
+        fprintf(stderr, "Canh bao: chi tao duoc %d/%d luong, phan con lai chay tren luong chinh\n",
+                started, count);
+        for (int t = started; t < count; t++) {
+            start((char*)args + t * argSize);
+        }
+    }
+    for (int t = 0; t < started; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    free(threads);
+}
+
+void* countShardLines(void* arg) {
+    IndexShard* shard = (IndexShard*)arg;
+    const unsigned char* p = shard->data + shard->begin;
+    const unsigned char* end = shard->data + shard->end;
+    int lines = 0;
+
+    while ((p = memchr(p, '\n', end - p)) != NULL) {
+        lines++;
+        p++;
+    }
+    shard->newlines = lines;
+    return NULL;
+}
+
+void* indexShard(void* arg) {
+    IndexShard* shard = (IndexShard*)arg;
+    Tokenizer tok;
+
+    /* Moi manh (tru manh dau) bat dau ngay sau '\n', nen afterPunctuation = 1 giong het lan chay tuan tu */
+    initTokenizer(&tok);
+    tok.lineNumber = shard->startLine;
+
+    initIndexTable(&shard->table);
+    tokenizeBlock(&tok, shard->data + shard->begin, shard->end - shard->begin, &shard->table);
+    finishTokenizer(&tok, &shard->table);
+    shard->afterPunctuation = tok.afterPunctuation;
+
+    sortIndexEntries(shard->table.entries, shard->table.count, 1);
+    return NULL;
+}
+
+/* Chi so dau tien trong bang da sap xep co word >= key */
+int lowerBoundWord(const IndexTable* table, const char* key) {
+    int lo = 0, hi = table->count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (strcmp(table->entries[mid].word, key) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/* Tron k-duong cac doan [from, to) cua moi manh; tu trung nhau duoc noi danh sach dong theo thu tu manh */
+void* mergeShardRange(void* arg) {
+    MergeTask* task = (MergeTask*)arg;
+    int total = 0;
+    for (int s = 0; s < task->shardCount; s++) {
+        total += task->to[s] - task->from[s];
+    }
+
+    task->out = (IndexEntry*)malloc((total > 0 ? total : 1) * sizeof(IndexEntry));
+    if (!task->out) {
+        perror("Loi cap phat bo nho khi tron chi muc");
+        exit(1);
+    }
+    task->outCount = 0;
+
+    int* cursor = (int*)malloc(task->shardCount * sizeof(int));
+    if (!cursor) {
+        perror("Loi cap phat bo nho khi tron chi muc");
+        exit(1);
+    }
+    memcpy(cursor, task->from, task->shardCount * sizeof(int));
+    for (;;) {
+        const char* smallest = NULL;
+        for (int s = 0; s < task->shardCount; s++) {
+            if (cursor[s] < task->to[s]) {
+                const char* w = task->shards[s].table.entries[cursor[s]].word;
+                if (!smallest || strcmp(w, smallest) < 0) {
+                    smallest = w;
+                }
+            }
+        }
+        if (!smallest) {
+            break;
+        }
+
+        IndexEntry* merged = NULL;
+        for (int s = 0; s < task->shardCount; s++) {
+            if (cursor[s] >= task->to[s]) {
+                continue;
+            }
+            IndexEntry* e = &task->shards[s].table.entries[cursor[s]];
+            if (e->word == smallest || strcmp(e->word, smallest) == 0) {
+                if (!merged) {
+                    merged = &task->out[task->outCount++];
+                    *merged = *e;
+                } else {
+                    appendPostings(&task->arena, merged, e);
+                }
+                cursor[s]++;
+            }
+        }
+    }
+
+    free(cursor);
+    return NULL;
+}
+
+/*
+ * Tron cac bang da sap xep cua jobs manh thanh table (da sap xep). Tu trung nhau duoc noi theo
+ * thu tu manh, vi vay manh truoc phai chua cac cap (tai lieu, dong) nho hon manh sau.
+ */
+void mergeShards(IndexShard* shards, int jobs, IndexTable* table) {
+    /* Lay moc chia khoang tu tu manh co nhieu tu nhat */
+    int biggest = 0;
+    for (int t = 1; t < jobs; t++) {
+        if (shards[t].table.count > shards[biggest].table.count) {
+            biggest = t;
+        }
+    }
+
+    MergeTask* tasks = (MergeTask*)calloc(jobs, sizeof(MergeTask));
+    int* bounds = (int*)malloc((size_t)(jobs + 1) * jobs * sizeof(int));
+    if (!tasks || !bounds) {
+        perror("Loi cap phat bo nho khi tron chi muc");
+        exit(1);
+    }
+    for (int k = 0; k <= jobs; k++) {
+        for (int s = 0; s < jobs; s++) {
+            int b;
+            if (k == 0) {
+                b = 0;
+            } else if (k == jobs || shards[biggest].table.count == 0) {
+                b = shards[s].table.count;
+            } else {
+                const IndexTable* big = &shards[biggest].table;
+                b = lowerBoundWord(&shards[s].table, big->entries[(long)big->count * k / jobs].word);
+            }
+            bounds[k * jobs + s] = b;
+        }
+    }
+
+    for (int t = 0; t < jobs; t++) {
+        tasks[t].shards = shards;
+        tasks[t].shardCount = jobs;
+        tasks[t].from = &bounds[t * jobs];
+        tasks[t].to = &bounds[(t + 1) * jobs];
+        initArena(&tasks[t].arena);
+    }
+
+    runThreads(mergeShardRange, tasks, sizeof(MergeTask), jobs);
+
+    int total = 0;
+    for (int t = 0; t < jobs; t++) {
+        total += tasks[t].outCount;
+    }
+    free(table->entries);
+    table->entries = (IndexEntry*)malloc((total > 0 ? total : 1) * sizeof(IndexEntry));
+    if (!table->entries) {
+        perror("Loi cap phat bo nho cho bang chi muc");
+        exit(1);
+    }
+    table->capacity = total > 0 ? total : 1;
+    table->count = 0;
+    for (int t = 0; t < jobs; t++) {
+        memcpy(&table->entries[table->count], tasks[t].out, tasks[t].outCount * sizeof(IndexEntry));
+        table->count += tasks[t].outCount;
+        free(tasks[t].out);
+    }
+
+    /* word/postings da chuyen sang bang ket qua: bang ket qua nhan luon arena cua tung manh */
+    for (int t = 0; t < jobs; t++) {
+        arenaAdopt(&table->arena, &shards[t].table.arena);
+        arenaAdopt(&table->arena, &tasks[t].arena);
+        free(shards[t].table.entries);
+        free(shards[t].table.buckets);
+    }
+    free(bounds);
+    free(tasks);
+}
+
+void* indexDocumentRange(void* arg) {
+    IndexShard* shard = (IndexShard*)arg;
+
+    initIndexTable(&shard->table);
+    for (int d = shard->firstDoc; d < shard->lastDoc; d++) {
+        processFile(g_documents[d], d, &shard->table);
+    }
+
+    sortIndexEntries(shard->table.entries, shard->table.count, 1);
+    return NULL;
+}
+
+/* Nhieu tai lieu: moi luong lap chi muc mot day tai lieu lien tiep, roi tron nhu cac manh cua mot tep */
+int processDocumentsParallel(IndexTable* table, int jobs) {
+    if (jobs > g_documentCount) {
+        jobs = g_documentCount;
+    }
+
+    IndexShard* shards = (IndexShard*)calloc(jobs, sizeof(IndexShard));
+    if (!shards) {
+        perror("Loi cap phat bo nho cho cac luong");
+        exit(1);
+    }
+
+    for (int t = 0; t < jobs; t++) {
+        shards[t].firstDoc = (int)((long)g_documentCount * t / jobs);
+        shards[t].lastDoc = (int)((long)g_documentCount * (t + 1) / jobs);
+    }
+    runThreads(indexDocumentRange, shards, sizeof(IndexShard), jobs);
+
+    mergeShards(shards, jobs, table);
+
+    free(shards);
+    return 1;
+}
+
+/*
+ * Chia tep thanh jobs manh tai bien dong, moi luong lap bang rieng voi so dong toan cuc,
+ * roi tron song song theo khoang tu khoa. Ket qua da sap xep.
+ */
+int processFileParallel(const char* filename, IndexTable* table, int jobs) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Loi: Khong mo duoc tep van ban: %s\n", filename);
+        exit(1);
+    }
+
+    size_t size;
+    const unsigned char* data = mapFile(fd, &size);
+    if (!data) {
+        close(fd);
+        return 0;
+    }
+
+    IndexShard* shards = (IndexShard*)calloc(jobs, sizeof(IndexShard));
+    if (!shards) {
+        perror("Loi cap phat bo nho cho cac luong");
+        exit(1);
+    }
+
+    size_t prev = 0;
+    for (int t = 0; t < jobs; t++) {
+        size_t cut = size;
+        if (t < jobs - 1) {
+            cut = size / jobs * (t + 1);
+            if (cut < prev) {
+                cut = prev;
+            }
+            const unsigned char* nl = memchr(data + cut, '\n', size - cut);
+            cut = nl ? (size_t)(nl - data) + 1 : size;
+        }
+        shards[t].data = data;
+        shards[t].begin = prev;
+        shards[t].end = cut;
+        prev = cut;
+    }
+
+    runThreads(countShardLines, shards, sizeof(IndexShard), jobs);
+
+    int line = 1;
+    for (int t = 0; t < jobs; t++) {
+        shards[t].startLine = line;
+        line += shards[t].newlines;
+    }
+
+    runThreads(indexShard, shards, sizeof(IndexShard), jobs);
+
+    mergeShards(shards, jobs, table);
+
+    /* Trang thai cuoi tep lay tu manh cuoi cung khong rong */
+    Tokenizer tok;
+    initTokenizer(&tok);
+    tok.lineNumber = line;
+    for (int t = 0; t < jobs; t++) {
+        if (shards[t].begin < shards[t].end) {
+            tok.afterPunctuation = shards[t].afterPunctuation;
+        }
+    }
+    size_t tailLen = size < BIN_TAIL_LEN ? size : BIN_TAIL_LEN;
+    finishDocState(&g_docStates[0], &tok, size, data + size - tailLen, tailLen);
+
+    free(shards);
+
+    unmapFile(data, size);
+    close(fd);
+    return 1;
+}
+#endif
+
+void pushTail(TailWindow* tail, const unsigned char* data, size_t n) {
+    if (n >= BIN_TAIL_LEN) {
+        memcpy(tail->bytes, data + n - BIN_TAIL_LEN, BIN_TAIL_LEN);
+        tail->len = BIN_TAIL_LEN;
+        return;
+    }
+    size_t keep = tail->len + n > BIN_TAIL_LEN ? BIN_TAIL_LEN - n : tail->len;
+    memmove(tail->bytes, tail->bytes + tail->len - keep, keep);
+    memcpy(tail->bytes + keep, data, n);
+    tail->len = keep + n;
+}
+
+/* Ghi lai cho che do cap nhat: tok da xu ly xong bytes byte, tail la cac byte cuoi cung */
+/* -U: ky tu cuoi cua tail la chu cai, hoac bi cat giua chung (coi nhu dang giua tu) */
+static int endsInLetterUtf8(const unsigned char* tail, size_t tailLen) {
+    size_t start = tailLen - 1;
+    while (start > 0 && tailLen - start < 4 && (tail[start] & 0xC0) == 0x80) {
+        start--;
+    }
+
+    uint32_t cp;
+    int n = decodeUtf8(tail + start, tailLen - start, &cp);
+    if (n == 0) {
+        return 1;
+    }
+    if (n < 0 || start + n != tailLen) {
+        return 0;
+    }
+    return unicodeClass(cp) == UNI_LETTER;
+}
+
+void finishDocState(BinDocState* state, const Tokenizer* tok, uint64_t bytes, const unsigned char* tail, size_t tailLen) {
+    int midWord;
+    if (g_utf8Mode && tailLen > 0 && tail[tailLen - 1] >= 0x80) {
+        midWord = endsInLetterUtf8(tail, tailLen);
+    } else {
+        midWord = tailLen > 0 && (g_charClass[tail[tailLen - 1]] & CLS_ALPHA);
+    }
+
+    state->indexedBytes = bytes;
+    state->lastLine = (uint32_t)tok->lineNumber;
+    /* Tu cuoi duoc flush o cuoi tep ma khong xoa afterPunctuation; neu doc tiep thi no da bi xoa */
+    state->flags = midWord ? BIN_DOC_MID_WORD : (tok->afterPunctuation ? BIN_DOC_AFTER_PUNCT : 0);
+    state->tailHash = binTailHash(tail, tailLen);
+}
+
+/* Doc het file theo khoi vao tok, khong flush tu cuoi; tra ve so byte da doc */
+uint64_t tokenizeStream(FILE* file, Tokenizer* tok, IndexTable* table, TailWindow* tail) {
+    unsigned char* buffer = (unsigned char*)malloc(READ_BLOCK_SIZE);
+    if (!buffer) {
+        perror("Loi cap phat bo nho cho bo dem doc");
+        exit(1);
+    }
+
+    uint64_t total = 0;
+    size_t n;
+    while ((n = fread(buffer, 1, READ_BLOCK_SIZE, file)) > 0) {
+        tokenizeBlock(tok, buffer, n, table);
+        pushTail(tail, buffer, n);
+        total += n;
+    }
+
+    free(buffer);
+    return total;
+}
+
+void processStream(FILE* file, int docId, IndexTable* table) {
+    Tokenizer tok;
+    initTokenizer(&tok);
+    tok.docId = docId;
+
+    TailWindow tail;
+    tail.len = 0;
+    uint64_t bytes = tokenizeStream(file, &tok, table, &tail);
+    finishTokenizer(&tok, table);
+
+    finishDocState(&g_docStates[docId], &tok, bytes, tail.bytes, tail.len);
+}
+
+void processFile(const char* filename, int docId, IndexTable* table) {
+    if (strcmp(filename, "-") == 0) {
+        processStream(stdin, docId, table);
+        g_docStates[docId].flags |= BIN_DOC_NO_RESUME;
+        return;
+    }
+
+    /* Nhi phan de so byte khop voi vi tri tep, can cho che do cap nhat */
+    FILE* file = fopen(filename, "rb");
+    if (!file) {
+        fprintf(stderr, "Loi: Khong mo duoc tep van ban: %s\n", filename);
+        exit(1);
+    }
+
+#ifndef _WIN32
+    /*
+     * Tep thuong duoc anh xa thang vao bo nho; pipe/FIFO hoac khi mmap loi thi doc theo khoi.
+     * Voi -m cung doc theo khoi, vi trang da anh xa cua tep lon van tinh vao RSS.
+     */
+    if (table->runs || !processMappedFile(fileno(file), docId, table)) {
+        processStream(file, docId, table);
+    }
+#else
+    processStream(file, docId, table);
+#endif
+
+    fclose(file);
+}
+
+/* -u: lay danh sach tai lieu va trang thai cuoi cua chung tu chi muc cu, giu nguyen ma tai lieu */
+void loadPreviousDocuments(const BinIndex* index) {
+    int count = (int)index->header->documentCount;
+    for (int d = 0; d < count; d++) {
+        addDocument(binIndexDocument(index, d));
+        g_docStates[d] = *binIndexDocState(index, d);
+    }
+    g_previousDocumentCount = count;
+}
+
+/*
+ * Lap chi muc phan noi them cua moi tai lieu (tai lieu moi: ca tep) vao delta, tiep tuc tu
+ * indexedBytes voi so dong va trang thai dau cau da luu. Tra ve 0 neu co tai lieu khong chi
+ * duoc noi them (ngan di, phan cu bi sua, hoac mot tu bi cat doi) - khi do phai lap lai toan bo.
+ */
+int indexAppendedText(IndexTable* delta) {
+    for (int d = 0; d < g_documentCount; d++) {
+        BinDocState* state = &g_docStates[d];
+        if (state->flags & BIN_DOC_NO_RESUME) {
+            fprintf(stderr, "Tai lieu %s doc tu dau vao chuan, lap lai toan bo chi muc\n", g_documents[d]);
+            return 0;
+        }
+
+        FILE* file = fopen(g_documents[d], "rb");
+        if (!file) {
+            fprintf(stderr, "Loi: Khong mo duoc tep van ban: %s\n", g_documents[d]);
+            exit(1);
+        }
+
+        TailWindow tail;
+        tail.len = state->indexedBytes < BIN_TAIL_LEN ? (size_t)state->indexedBytes : BIN_TAIL_LEN;
+        int unchanged = fseek(file, (long)(state->indexedBytes - tail.len), SEEK_SET) == 0 &&
+                        fread(tail.bytes, 1, tail.len, file) == tail.len &&
+                        binTailHash(tail.bytes, tail.len) == state->tailHash;
+        if (unchanged && (state->flags & BIN_DOC_MID_WORD)) {
+            int c = fgetc(file);
+            /* -U: ky tu ngoai ASCII co the noi tiep chu cai (hoac ky tu bi cat) o cuoi phan cu */
+            unchanged = c == EOF || !((g_charClass[c] & CLS_ALPHA) || (g_utf8Mode && c >= 0x80));
+            if (c != EOF) {
+                ungetc(c, file);
+            }
+        }
+        if (!unchanged) {
+            fprintf(stderr, "Tai lieu %s khong chi duoc noi them, lap lai toan bo chi muc\n", g_documents[d]);
+            fclose(file);
+            return 0;
+        }
+
+        Tokenizer tok;
+        initTokenizer(&tok);
+        tok.docId = d;
+        tok.lineNumber = (int)state->lastLine;
+        tok.afterPunctuation = (state->flags & BIN_DOC_AFTER_PUNCT) != 0;
+
+        uint64_t bytes = tokenizeStream(file, &tok, delta, &tail);
+        finishTokenizer(&tok, delta);
+        if (bytes > 0) {
+            finishDocState(state, &tok, state->indexedBytes + bytes, tail.bytes, tail.len);
+        }
+        fclose(file);
+    }
+    return 1;
+}
+
+/* Entry chi doc tro thang vao danh sach dong trong chi muc cu (phai con anh xa khi ghi ket qua) */
+void entryFromBinTerm(Arena* arena, const BinTerm* term, IndexEntry* entry) {
+    entry->word = arenaStrdup(arena, term->word);
+    entry->hash = hashWord(term->word);
+    entry->count = (int)term->count;
+    entry->postings = (unsigned char*)term->postings;
+    entry->posting_size = (int)term->postingSize;
+    entry->posting_capacity = entry->posting_size;
+    lastBinPosting(term, &entry->last_doc_added, &entry->last_line_added);
+}
+
+/* Gop danh sach cua src vao dst (ca hai tang dan); dst duoc chep sang vung moi trong arena */
+void mergePostings(Arena* arena, IndexEntry* dst, const IndexEntry* src) {
+    int firstDoc = 0, firstLine = 0;
+    decodePosting(src->postings, &firstDoc, &firstLine);
+
+    int capacity = INITIAL_POSTING_CAP;
+    while (capacity < dst->posting_size + src->posting_size + 3 * MAX_VARINT_LEN) {
+        capacity *= 2;
+    }
+    unsigned char* buffer = (unsigned char*)arenaAlloc(arena, capacity);
+
+    /* Thuong gap: phan noi them nam sau moi cap cu, chi can noi */
+    if (firstDoc > dst->last_doc_added || (firstDoc == dst->last_doc_added && firstLine > dst->last_line_added)) {
+        memcpy(buffer, dst->postings, dst->posting_size);
+        dst->postings = buffer;
+        dst->posting_capacity = capacity;
+        appendPostings(arena, dst, src);
+        return;
+    }
+
+    /* Tai lieu moi xen giua cac tai lieu cu: tron hai danh sach va ma hoa lai */
+    IndexEntry merged = *dst;
+    merged.postings = buffer;
+    merged.posting_capacity = capacity;
+    merged.posting_size = 0;
+    merged.count = dst->count + src->count;
+    merged.last_doc_added = 0;
+    merged.last_line_added = 0;
+
+    PostingCursor a, b;
+    initPostingCursor(&a, dst->postings, dst->posting_size);
+    initPostingCursor(&b, src->postings, src->posting_size);
+    int hasA = nextPosting(&a), hasB = nextPosting(&b);
+    while (hasA || hasB) {
+        if (hasA && (!hasB || a.doc < b.doc || (a.doc == b.doc && a.line <= b.line))) {
+            addLinePosting(arena, &merged, a.doc, a.line);
+            hasA = nextPosting(&a);
+        } else {
+            addLinePosting(arena, &merged, b.doc, b.line);
+            hasB = nextPosting(&b);
+        }
+    }
+    *dst = merged;
+}
+
+/*
+ * Tron danh sach tu da sap xep cua chi muc cu voi delta (da sap xep) thanh table. Chi tu xuat hien
+ * trong delta moi bi chep va ghep danh sach dong; delta duoc giai phong, arena cua no chuyen cho table.
+ */
+void mergeWithPreviousIndex(const BinIndex* index, IndexTable* delta, IndexTable* table) {
+    int capacity = (int)index->header->termCount + delta->count;
+    free(table->entries);
+    table->entries = (IndexEntry*)malloc((capacity > 0 ? capacity : 1) * sizeof(IndexEntry));
+    if (!table->entries) {
+        perror("Loi cap phat bo nho cho bang chi muc");
+        exit(1);
+    }
+    table->capacity = capacity > 0 ? capacity : 1;
+    table->count = 0;
+
+    BinTermIterator it;
+    initBinTermIterator(&it, index);
+    int hasOld = nextBinTerm(&it);
+    int i = 0;
+    while (hasOld || i < delta->count) {
+        int cmp = !hasOld ? 1 : i >= delta->count ? -1 : strcmp(it.term.word, delta->entries[i].word);
+        IndexEntry* entry = &table->entries[table->count++];
+        if (cmp > 0) {
+            *entry = delta->entries[i++];
+            continue;
+        }
+
+        entryFromBinTerm(&table->arena, &it.term, entry);
+        if (cmp == 0) {
+            mergePostings(&table->arena, entry, &delta->entries[i++]);
+        }
+        hasOld = nextBinTerm(&it);
+    }
+    if (it.corrupt) {
+        exit(1);
+    }
+
+    arenaAdopt(&table->arena, &delta->arena);
+    freeIndexTable(delta);
+}
+
+/******************* Ghi ra dia khi vuot ngan sach bo nho (-m) ******************************/
+
+/* Bo nho bang dang giu: arena (word, postings) cong mang entry va mang bam */
+size_t tableMemory(const IndexTable* table) {
+    return table->arena.bytesReserved + (size_t)table->capacity * sizeof(IndexEntry) +
+           (size_t)table->bucketCount * sizeof(int);
+}
+
+void runFileName(const RunSet* runs, int run, char* name, size_t size) {
+    snprintf(name, size, "%s.run%d", runs->prefix, run);
+}
+
+/* Ban ghi run: varint do dai, tu, varint count, lastDoc, lastLine, so byte danh sach, danh sach */
+void writeRunEntry(FILE* file, const IndexEntry* entry) {
+    unsigned char varints[4 * MAX_VARINT_LEN];
+    size_t length = strlen(entry->word);
+    int n = encodeVarint(varints, (unsigned int)length);
+    fwrite(varints, 1, n, file);
+    fwrite(entry->word, 1, length, file);
+
+    n = encodeVarint(varints, (unsigned int)entry->count);
+    n += encodeVarint(varints + n, (unsigned int)entry->last_doc_added);
+    n += encodeVarint(varints + n, (unsigned int)entry->last_line_added);
+    n += encodeVarint(varints + n, (unsigned int)entry->posting_size);
+    fwrite(varints, 1, n, file);
+    fwrite(entry->postings, 1, entry->posting_size, file);
+}
+
+/* Sap xep bang, ghi thanh mot run roi lam rong bang (giu runs) */
+void spillTable(IndexTable* table) {
+    RunSet* runs = table->runs;
+    if (table->count == 0) {
+        return;
+    }
+
+    sortIndexEntries(table->entries, table->count, runs->jobs);
+
+    char name[MAX_PATH_LEN];
+    runFileName(runs, runs->count, name, sizeof(name));
+    FILE* file = fopen(name, "wb");
+    if (!file) {
+        fprintf(stderr, "Loi: Khong the tao tep tam %s\n", name);
+        exit(1);
+    }
+    setvbuf(file, NULL, _IOFBF, READ_BLOCK_SIZE);
+    for (int i = 0; i < table->count; i++) {
+        writeRunEntry(file, &table->entries[i]);
+    }
+    if (fclose(file) != 0) {
+        perror("Loi ghi tep tam");
+        exit(1);
+    }
+    runs->count++;
+
+    freeIndexTable(table);
+    initIndexTable(table);
+    table->runs = runs;
+}
+
+static int readVarintFile(FILE* file, unsigned int* value) {
+    unsigned int v = 0;
+    int shift = 0;
+    int c;
+    do {
+        c = fgetc(file);
+        if (c == EOF) {
+            return 0;
+        }
+        v |= (unsigned int)(c & 0x7F) << shift;
+        shift += 7;
+    } while (c & 0x80);
+    *value = v;
+    return 1;
+}
+
+int readRunEntry(RunReader* reader) {
+    unsigned int length, count, lastDoc, lastLine, size;
+    if (!readVarintFile(reader->file, &length)) {
+        return 0;
+    }
+    if (length >= MAX_WORD_LEN || fread(reader->word, 1, length, reader->file) != length ||
+        !readVarintFile(reader->file, &count) || !readVarintFile(reader->file, &lastDoc) ||
+        !readVarintFile(reader->file, &lastLine) || !readVarintFile(reader->file, &size)) {
+        fprintf(stderr, "Loi: Tep tam bi hong\n");
+        exit(1);
+    }
+    reader->word[length] = '\0';
+    reader->count = (int)count;
+    reader->lastDoc = (int)lastDoc;
+    reader->lastLine = (int)lastLine;
+
+    if (size > reader->capacity) {
+        reader->capacity = size;
+        reader->postings = (unsigned char*)realloc(reader->postings, reader->capacity);
+        if (!reader->postings) {
+            perror("Loi cap phat bo nho khi tron run");
+            exit(1);
+        }
+    }
+    if (fread(reader->postings, 1, size, reader->file) != size) {
+        fprintf(stderr, "Loi: Tep tam bi hong\n");
+        exit(1);
+    }
+    reader->size = size;
+    return 1;
+}
+
+/* Thu tu trong heap: theo tu, tu bang nhau thi run truoc ra truoc de noi danh sach dung thu tu */
+static int runBefore(const RunReader* readers, int a, int b) {
+    int cmp = strcmp(readers[a].word, readers[b].word);
+    return cmp < 0 || (cmp == 0 && a < b);
+}
+
+static void siftDownRun(const RunReader* readers, int* heap, int size, int i) {
+    for (;;) {
+        int smallest = i, left = 2 * i + 1, right = left + 1;
+        if (left < size && runBefore(readers, heap[left], heap[smallest])) smallest = left;
+        if (right < size && runBefore(readers, heap[right], heap[smallest])) smallest = right;
+        if (smallest == i) {
+            return;
+        }
+        int t = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = t;
+        i = smallest;
+    }
+}
+
+/*
+ * Tron k-duong cac run [first, first + count) bang heap; moi tu chi giu trong bo nho danh sach
+ * dong cua chinh no. Cac run da tron bi xoa.
+ */
+void mergeRunRange(const RunSet* runs, int first, int count, EntrySink sink, void* context) {
+    RunReader* readers = (RunReader*)calloc(count, sizeof(RunReader));
+    int* heap = (int*)malloc(count * sizeof(int));
+    if (!readers || !heap) {
+        perror("Loi cap phat bo nho khi tron run");
+        exit(1);
+    }
+
+    int heapSize = 0;
+    for (int r = 0; r < count; r++) {
+        char name[MAX_PATH_LEN];
+        runFileName(runs, first + r, name, sizeof(name));
+        readers[r].file = fopen(name, "rb");
+        if (!readers[r].file) {
+            fprintf(stderr, "Loi: Khong mo duoc tep tam %s\n", name);
+            exit(1);
+        }
+        setvbuf(readers[r].file, NULL, _IOFBF, READ_BLOCK_SIZE);
+        if (readRunEntry(&readers[r])) {
+            heap[heapSize++] = r;
+        }
+    }
+    for (int i = heapSize / 2 - 1; i >= 0; i--) {
+        siftDownRun(readers, heap, heapSize, i);
+    }
+
+    unsigned char* postings = NULL;
+    size_t size = 0, capacity = 0;
+    char word[MAX_WORD_LEN];
+    while (heapSize > 0) {
+        IndexEntry merged;
+        int r = heap[0];
+        strcpy(word, readers[r].word);
+        merged.word = word;
+        merged.count = 0;
+        merged.last_doc_added = 0;
+        merged.last_line_added = 0;
+        size = 0;
+
+        while (heapSize > 0 && strcmp(readers[heap[0]].word, word) == 0) {
+            RunReader* reader = &readers[heap[0]];
+
+            /* Chi cap dau phai ma hoa lai; cung mot dong co the bi cat doi giua hai run */
+            int doc = 0, line = 0;
+            int head = decodePosting(reader->postings, &doc, &line);
+            if (size == 0 || doc != merged.last_doc_added || line != merged.last_line_added) {
+                unsigned char first[3 * MAX_VARINT_LEN];
+                int n = encodePosting(first, merged.last_doc_added, merged.last_line_added, doc, line);
+                appendBytes(&postings, &size, &capacity, first, n);
+            }
+            appendBytes(&postings, &size, &capacity, reader->postings + head, reader->size - head);
+            merged.count += reader->count;
+            merged.last_doc_added = reader->lastDoc;
+            merged.last_line_added = reader->lastLine;
+
+            if (readRunEntry(reader)) {
+                siftDownRun(readers, heap, heapSize, 0);
+            } else {
+                heap[0] = heap[--heapSize];
+                siftDownRun(readers, heap, heapSize, 0);
+            }
+        }
+
+        merged.postings = postings;
+        merged.posting_size = (int)size;
+        merged.posting_capacity = (int)capacity;
+        sink(context, &merged);
+    }
+
+    for (int r = 0; r < count; r++) {
+        char name[MAX_PATH_LEN];
+        fclose(readers[r].file);
+        free(readers[r].postings);
+        runFileName(runs, first + r, name, sizeof(name));
+        remove(name);
+    }
+    free(postings);
+    free(heap);
+    free(readers);
+}
+
+void writeRunSink(void* context, const IndexEntry* entry) {
+    writeRunEntry((FILE*)context, entry);
+}
+
+void writeOutputSink(void* context, const IndexEntry* entry) {
+    OutputSinks* out = (OutputSinks*)context;
+    writeTextEntry(out->text, entry);
+    if (out->binary) {
+        addBinIndexEntry(out->binary, entry);
+    }
+}
+
+/*
+ * Tron moi run thanh output (va chi muc nhi phan neu co). Qua nhieu run thi tron truoc tung nhom
+ * MAX_RUN_FANIN run lien tiep thanh run moi, giu thu tu, de khong mo qua nhieu tep cung luc.
+ */
+void writeMergedRuns(RunSet* runs, const char* outputFilename, const char* binaryFilename) {
+    while (runs->count - runs->first > MAX_RUN_FANIN) {
+        int levelEnd = runs->count;
+        for (int group = runs->first; group < levelEnd; group += MAX_RUN_FANIN) {
+            int n = levelEnd - group < MAX_RUN_FANIN ? levelEnd - group : MAX_RUN_FANIN;
+            char name[MAX_PATH_LEN];
+            runFileName(runs, runs->count, name, sizeof(name));
+            FILE* file = fopen(name, "wb");
+            if (!file) {
+                fprintf(stderr, "Loi: Khong the tao tep tam %s\n", name);
+                exit(1);
+            }
+            setvbuf(file, NULL, _IOFBF, READ_BLOCK_SIZE);
+            runs->count++;
+            mergeRunRange(runs, group, n, writeRunSink, file);
+            if (fclose(file) != 0) {
+                perror("Loi ghi tep tam");
+                exit(1);
+            }
+        }
+        runs->first = levelEnd;
+    }
+
+    OutputSinks out;
+    TextWriter text;
+    BinIndexWriter writer;
+    if (!openTextWriter(&text, outputFilename)) {
+        return;
+    }
+    out.text = &text;
+    out.binary = binaryFilename && openBinIndexWriter(&writer, binaryFilename) ? &writer : NULL;
+
+    mergeRunRange(runs, runs->first, runs->count - runs->first, writeOutputSink, &out);
+    runs->first = runs->count;
+
+    closeTextWriter(&text);
+    if (out.binary) {
+        closeBinIndexWriter(out.binary);
+    }
+}
+
+/* --stats: thong ke bo nho ra stderr de khong lan vao ket qua */
+void printStats(const IndexTable* table) {
+    const Arena* arena = &table->arena;
+    if (table->runs) {
+        fprintf(stderr, "So run ghi ra dia: %d (ngan sach %zu MB)\n", table->runs->count, table->runs->budget >> 20);
+    }
+    fprintf(stderr, "So tu: %d\n", table->count);
+    if (table->stats) {
+        const PairCounter* pairs = &table->stats->pairs;
+        fprintf(stderr, "Bo dem cap tu: %d/%d, thay the %llu lan\n", pairs->count, pairs->capacity,
+                (unsigned long long)pairs->evictions);
+    }
+    fprintf(stderr, "Cap phat tu arena: %zu (dung lai %zu)\n", arena->allocCount, arena->reuseCount);
+    fprintf(stderr, "Khoi arena (malloc): %zu, %.1f MB\n", arena->blockCount,
+            arena->bytesReserved / (1024.0 * 1024.0));
+    double peakMB = peakRssMB();
+    if (peakMB >= 0) {
+        fprintf(stderr, "RSS dinh: %.1f MB\n", peakMB);
+    }
+}
+
+/* RSS lon nhat cua tien trinh tu luc chay, -1 neu khong biet */
+double peakRssMB(void) {
+#ifndef _WIN32
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+        return usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+        return usage.ru_maxrss / 1024.0;
+#endif
+    }
+#endif
+    return -1;
+}
+
+void initTermStats(TermStats* stats, size_t budget) {
+    initPairCounter(&stats->pairs, budget);
+    stats->previousTerm = -1;
+    stats->previousDoc = -1;
+}
+
+void countTermPair(TermStats* stats, int docId, int term) {
+    if (stats->previousTerm >= 0 && stats->previousDoc == docId) {
+        countPair(&stats->pairs, ((uint64_t)(uint32_t)stats->previousTerm << 32) | (uint32_t)term);
+    }
+    stats->previousTerm = term;
+    stats->previousDoc = docId;
+}
+
+void freeTermStats(TermStats* stats) {
+    freePairCounter(&stats->pairs);
+}
+
+/* So lan giam dan, cung so lan thi theo thu tu tu dien */
+int termBefore(const void* context, const TopItem* a, const TopItem* b) {
+    const IndexTable* table = (const IndexTable*)context;
+    if (a->count != b->count) {
+        return a->count > b->count;
+    }
+    return strcmp(table->entries[a->id].word, table->entries[b->id].word) < 0;
+}
+
+int pairBefore(const void* context, const TopItem* a, const TopItem* b) {
+    const IndexTable* table = (const IndexTable*)context;
+    if (a->count != b->count) {
+        return a->count > b->count;
+    }
+    uint64_t keyA = table->stats->pairs.pairs[a->id].key;
+    uint64_t keyB = table->stats->pairs.pairs[b->id].key;
+    int cmp = strcmp(table->entries[keyA >> 32].word, table->entries[keyB >> 32].word);
+    if (cmp == 0) {
+        cmp = strcmp(table->entries[(uint32_t)keyA].word, table->entries[(uint32_t)keyB].word);
+    }
+    return cmp < 0;
+}
+
+void writeTopTerms(const IndexTable* table, int k, const char* outputFilename) {
+    FILE* file = fopen(outputFilename, "w");
+    if (!file) {
+        fprintf(stderr, "Loi: Khong the mo tep dau ra %s\n", outputFilename);
+        return;
+    }
+
+    TopHeap heap;
+    initTopHeap(&heap, k, termBefore, table);
+    for (int i = 0; i < table->count; i++) {
+        offerTopHeap(&heap, (uint64_t)table->entries[i].count, i);
+    }
+    sortTopHeap(&heap);
+
+    for (int i = 0; i < heap.size; i++) {
+        fprintf(file, "%s %llu\n", table->entries[heap.items[i].id].word, (unsigned long long)heap.items[i].count);
+    }
+
+    freeTopHeap(&heap);
+    fclose(file);
+}
+
+/* Moi dong: tu_truoc tu_sau so_lan sai_so; so lan that nam trong [so_lan - sai_so, so_lan] */
+void writeTopPairs(const IndexTable* table, int k, const char* outputFilename) {
+    FILE* file = fopen(outputFilename, "w");
+    if (!file) {
+        fprintf(stderr, "Loi: Khong the mo tep dau ra %s\n", outputFilename);
+        return;
+    }
+
+    const PairCounter* pairs = &table->stats->pairs;
+    TopHeap heap;
+    initTopHeap(&heap, k, pairBefore, table);
+    for (int i = 0; i < pairs->count; i++) {
+        offerTopHeap(&heap, pairs->pairs[i].count, i);
+    }
+    sortTopHeap(&heap);
+
+    for (int i = 0; i < heap.size; i++) {
+        const PairCount* pair = &pairs->pairs[heap.items[i].id];
+        fprintf(file, "%s %s %llu %llu\n", table->entries[pair->key >> 32].word,
+                table->entries[(uint32_t)pair->key].word,
+                (unsigned long long)pair->count, (unsigned long long)pair->error);
+    }
+
+    freeTopHeap(&heap);
+    fclose(file);
+}
+
+void printDocumentList(const char* outputFilename) {
+    FILE* file = fopen(outputFilename, "w");
+    if (!file) {
+        fprintf(stderr, "Loi: Khong the mo tep dau ra %s\n", outputFilename);
+        return;
+    }
+
+    for (int i = 0; i < g_documentCount; i++) {
+        fprintf(file, "%d %s\n", i, g_documents[i]);
+    }
+
+    fclose(file);
+}
+
+void printIndexTable(const IndexTable* table, const char* outputFilename) {
+    TextWriter writer;
+    if (!openTextWriter(&writer, outputFilename)) {
+        return;
+    }
+
+    for (int i = 0; i < table->count; i++) {
+        writeTextEntry(&writer, &table->entries[i]);
+    }
+
+    closeTextWriter(&writer);
+}
+
+int openTextWriter(TextWriter* writer, const char* outputFilename) {
+#ifndef _WIN32
+    writer->fd = open(outputFilename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (writer->fd < 0) {
+#else
+    writer->file = fopen(outputFilename, "w");
+    if (!writer->file) {
+#endif
+        fprintf(stderr, "Loi: Khong the mo tep dau ra %s\n", outputFilename);
+        return 0;
+    }
+
+    writer->buffer = (char*)malloc(OUTPUT_BUFFER_SIZE);
+    if (!writer->buffer) {
+        perror("Loi cap phat bo nho cho bo dem ghi");
+        exit(1);
+    }
+    writer->used = 0;
+    return 1;
+}
+
+void flushTextWriter(TextWriter* writer) {
+#ifndef _WIN32
+    size_t done = 0;
+    while (done < writer->used) {
+        ssize_t n = write(writer->fd, writer->buffer + done, writer->used - done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("Loi ghi tep dau ra");
+            exit(1);
+        }
+        done += (size_t)n;
+    }
+#else
+    if (fwrite(writer->buffer, 1, writer->used, writer->file) != writer->used) {
+        perror("Loi ghi tep dau ra");
+        exit(1);
+    }
+#endif
+    writer->used = 0;
+}
+
+void closeTextWriter(TextWriter* writer) {
+    flushTextWriter(writer);
+#ifndef _WIN32
+    close(writer->fd);
+#else
+    fclose(writer->file);
+#endif
+    free(writer->buffer);
+}
+
+static const char g_digitPairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/* Ghi value dang thap phan vao out, tra ve so ky tu (khong them '\0') */
+static int formatUint(char* out, unsigned int value) {
+    char digits[10];
+    int n = 10;
+    while (value >= 100) {
+        unsigned int pair = (value % 100) * 2;
+        value /= 100;
+        digits[--n] = g_digitPairs[pair + 1];
+        digits[--n] = g_digitPairs[pair];
+    }
+    if (value >= 10) {
+        digits[--n] = g_digitPairs[value * 2 + 1];
+        digits[--n] = g_digitPairs[value * 2];
+    } else {
+        digits[--n] = (char)('0' + value);
+    }
+    memcpy(out, digits + n, 10 - n);
+    return 10 - n;
+}
+
+/* Mot dong "tu count,dong,..." (hoac ",tai_lieu:dong"), giai ma thang tu danh sach nen */
+void writeTextEntry(TextWriter* writer, const IndexEntry* entry) {
+    size_t length = strlen(entry->word);
+    if (writer->used + length + 2 + MAX_POSTING_TEXT > OUTPUT_BUFFER_SIZE) {
+        flushTextWriter(writer);
+    }
+
+    char* out = writer->buffer + writer->used;
+    memcpy(out, entry->word, length);
+    out += length;
+    *out++ = ' ';
+    out += formatUint(out, (unsigned int)entry->count);
+
+    int multiDoc = g_documentCount > 1;
+    int doc = 0, line = 0;
+    const unsigned char* p = entry->postings;
+    const unsigned char* end = p + entry->posting_size;
+    while (p < end) {
+        if (out + MAX_POSTING_TEXT + 1 > writer->buffer + OUTPUT_BUFFER_SIZE) {
+            writer->used = (size_t)(out - writer->buffer);
+            flushTextWriter(writer);
+            out = writer->buffer;
+        }
+        p += decodePosting(p, &doc, &line);
+        *out++ = ',';
+        if (multiDoc) {
+            out += formatUint(out, (unsigned int)doc);
+            *out++ = ':';
+        }
+        out += formatUint(out, (unsigned int)line);
+    }
+    *out++ = '\n';
+    writer->used = (size_t)(out - writer->buffer);
+}
+
+void appendBytes(unsigned char** buf, size_t* size, size_t* capacity, const void* data, size_t n) {
+    if (*size + n > *capacity) {
+        while (*size + n > *capacity) {
+            *capacity = *capacity ? *capacity * 2 : READ_BLOCK_SIZE;
+        }
+        *buf = (unsigned char*)realloc(*buf, *capacity);
+        if (!*buf) {
+            perror("Loi cap phat bo nho khi ghi chi muc nhi phan");
+            exit(1);
+        }
+    }
+    memcpy(*buf + *size, data, n);
+    *size += n;
+}
+
+void writePadding(FILE* file, uint64_t* offset) {
+    static const char zeros[8] = {0};
+    size_t pad = (size_t)((8 - *offset % 8) % 8);
+    fwrite(zeros, 1, pad, file);
+    *offset += pad;
+}
+
+/*
+ * Ghi chi muc nhi phan theo tung tu (da sap xep): danh sach dong duoc ghi thang ra tep ngay sau
+ * header, cac phan con lai (ty le voi so tu, khong phai so cap) giu trong bo nho den khi dong tep.
+ */
+int openBinIndexWriter(BinIndexWriter* writer, const char* outputFilename) {
+    memset(writer, 0, sizeof(BinIndexWriter));
+    writer->file = fopen(outputFilename, "wb");
+    if (!writer->file) {
+        fprintf(stderr, "Loi: Khong the mo tep dau ra %s\n", outputFilename);
+        return 0;
+    }
+
+    /* header that duoc ghi lai khi dong tep */
+    BinIndexHeader header;
+    memset(&header, 0, sizeof(header));
+    fwrite(&header, sizeof(header), 1, writer->file);
+    return 1;
+}
+
+void addBinIndexEntry(BinIndexWriter* writer, const IndexEntry* entry) {
+    unsigned char varint[MAX_VARINT_LEN];
+    size_t prefix = 0;
+
+    if (writer->termCount % BIN_TERMS_PER_BLOCK == 0) {
+        BinTermBlock block;
+        block.termOffset = writer->termsSize;
+        block.postingOffset = writer->postingOffset;
+        block.skipOffset = writer->skipsSize / sizeof(BinSkip);
+        appendBytes(&writer->blocks, &writer->blocksSize, &writer->blocksCapacity, &block, sizeof(block));
+    } else {
+        while (writer->previous[prefix] && writer->previous[prefix] == entry->word[prefix]) {
+            prefix++;
+        }
+    }
+    size_t length = strlen(entry->word);
+    size_t suffix = length - prefix;
+
+    PostingCursor cursor;
+    unsigned int skipCount = 0;
+    int postings = 0;
+    initPostingCursor(&cursor, entry->postings, entry->posting_size);
+    for (;;) {
+        if (postings > 0 && postings % BIN_SKIP_INTERVAL == 0 && cursor.p < cursor.end) {
+            BinSkip skip;
+            skip.doc = (uint32_t)cursor.doc;
+            skip.line = (uint32_t)cursor.line;
+            skip.offset = (uint32_t)(cursor.p - entry->postings);
+            appendBytes(&writer->skips, &writer->skipsSize, &writer->skipsCapacity, &skip, sizeof(skip));
+            skipCount++;
+        }
+        if (!nextPosting(&cursor)) {
+            break;
+        }
+        postings++;
+    }
+
+    appendBytes(&writer->terms, &writer->termsSize, &writer->termsCapacity, varint, encodeVarint(varint, (unsigned int)prefix));
+    appendBytes(&writer->terms, &writer->termsSize, &writer->termsCapacity, varint, encodeVarint(varint, (unsigned int)suffix));
+    appendBytes(&writer->terms, &writer->termsSize, &writer->termsCapacity, entry->word + prefix, suffix);
+    appendBytes(&writer->terms, &writer->termsSize, &writer->termsCapacity, varint, encodeVarint(varint, (unsigned int)entry->count));
+    appendBytes(&writer->terms, &writer->termsSize, &writer->termsCapacity, varint, encodeVarint(varint, (unsigned int)entry->posting_size));
+    appendBytes(&writer->terms, &writer->termsSize, &writer->termsCapacity, varint, encodeVarint(varint, skipCount));
+
+    fwrite(entry->postings, 1, entry->posting_size, writer->file);
+    writer->postingOffset += entry->posting_size;
+    memcpy(writer->previous, entry->word, length + 1);
+    writer->termCount++;
+}
+
+void closeBinIndexWriter(BinIndexWriter* writer) {
+    BinIndexHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BIN_INDEX_MAGIC, 4);
+    header.version = BIN_INDEX_VERSION;
+    header.byteOrder = BIN_INDEX_BYTE_ORDER;
+    header.termCount = writer->termCount;
+    header.blockCount = (uint32_t)(writer->blocksSize / sizeof(BinTermBlock));
+    header.documentCount = (uint32_t)g_documentCount;
+    header.flags = g_utf8Mode ? BIN_INDEX_UTF8 : 0;
+    header.postingsOffset = sizeof(BinIndexHeader);
+    header.postingsSize = writer->postingOffset;
+
+    uint64_t offset = header.postingsOffset + header.postingsSize;
+    writePadding(writer->file, &offset);
+    header.blocksOffset = offset;
+    header.docStatesOffset = header.blocksOffset + writer->blocksSize;
+    header.skipsOffset = header.docStatesOffset + (uint64_t)g_documentCount * sizeof(BinDocState);
+    header.skipCount = writer->skipsSize / sizeof(BinSkip);
+    header.termsOffset = header.skipsOffset + writer->skipsSize;
+    header.termsSize = writer->termsSize;
+
+    fwrite(writer->blocks, 1, writer->blocksSize, writer->file);
+    fwrite(g_docStates, sizeof(BinDocState), g_documentCount, writer->file);
+    fwrite(writer->skips, 1, writer->skipsSize, writer->file);
+    fwrite(writer->terms, 1, writer->termsSize, writer->file);
+    offset = header.termsOffset + header.termsSize;
+    writePadding(writer->file, &offset);
+    header.documentsOffset = offset;
+
+    uint64_t pathOffset = header.documentsOffset + (uint64_t)g_documentCount * sizeof(uint64_t);
+    for (int d = 0; d < g_documentCount; d++) {
+        fwrite(&pathOffset, sizeof(pathOffset), 1, writer->file);
+        pathOffset += strlen(g_documents[d]) + 1;
+    }
+    for (int d = 0; d < g_documentCount; d++) {
+        fwrite(g_documents[d], 1, strlen(g_documents[d]) + 1, writer->file);
+    }
+
+    fseek(writer->file, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, writer->file);
+    if (fclose(writer->file) != 0) {
+        perror("Loi ghi tep chi muc nhi phan");
+    }
+    free(writer->skips);
+    free(writer->terms);
+    free(writer->blocks);
+}
+
+/* Ghi bang da sap xep theo dinh dang trong binindex.h */
+void writeBinaryIndex(const IndexTable* table, const char* outputFilename) {
+    BinIndexWriter writer;
+    if (!openBinIndexWriter(&writer, outputFilename)) {
+        return;
+    }
+    for (int i = 0; i < table->count; i++) {
+        addBinIndexEntry(&writer, &table->entries[i]);
+    }
+    closeBinIndexWriter(&writer);
+}
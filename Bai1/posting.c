@@ -0,0 +1,71 @@
+#include <stddef.h>
+#include "posting.h"
+
+int encodeVarint(unsigned char* out, unsigned int value) {
+    int n = 0;
+    while (value >= 0x80) {
+        out[n++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (unsigned char)value;
+    return n;
+}
+
+int decodeVarint(const unsigned char* in, unsigned int* value) {
+    unsigned int v = 0;
+    int shift = 0;
+    int n = 0;
+    unsigned char b;
+    do {
+        b = in[n++];
+        v |= (unsigned int)(b & 0x7F) << shift;
+        shift += 7;
+    } while (b & 0x80);
+    *value = v;
+    return n;
+}
+
+/*
+ * Cung tai lieu: mot varint (line - lastLine) >= 1.
+ * Sang tai lieu moi: varint 0, roi (doc - lastDoc), roi so dong tuyet doi.
+ * Chi muc mot tai lieu vi vay giu nguyen dang delta dong thuan tuy.
+ */
+int encodePosting(unsigned char* out, int lastDoc, int lastLine, int doc, int line) {
+    if (doc == lastDoc) {
+        return encodeVarint(out, (unsigned int)(line - lastLine));
+    }
+    int n = encodeVarint(out, 0);
+    n += encodeVarint(out + n, (unsigned int)(doc - lastDoc));
+    n += encodeVarint(out + n, (unsigned int)line);
+    return n;
+}
+
+/* doc/line vao la trang thai truoc do, ra la cap (tai lieu, dong) vua giai ma */
+int decodePosting(const unsigned char* in, int* doc, int* line) {
+    unsigned int v;
+    int n = decodeVarint(in, &v);
+    if (v != 0) {
+        *line += (int)v;
+        return n;
+    }
+    n += decodeVarint(in + n, &v);
+    *doc += (int)v;
+    n += decodeVarint(in + n, &v);
+    *line = (int)v;
+    return n;
+}
+
+void initPostingCursor(PostingCursor* cursor, const unsigned char* data, size_t size) {
+    cursor->p = data;
+    cursor->end = data + size;
+    cursor->doc = 0;
+    cursor->line = 0;
+}
+
+int nextPosting(PostingCursor* cursor) {
+    if (cursor->p >= cursor->end) {
+        return 0;
+    }
+    cursor->p += decodePosting(cursor->p, &cursor->doc, &cursor->line);
+    return 1;
+}
@@ -0,0 +1,26 @@
+#ifndef __POSTING_H__
+#define __POSTING_H__
+
+#include <stddef.h>
+
+/* Mot so nguyen 32 bit can toi da 5 byte varint */
+#define MAX_VARINT_LEN 5
+
+/* Duyet tuan tu mot danh sach (tai lieu, dong) da ma hoa */
+typedef struct {
+    const unsigned char* p;
+    const unsigned char* end;
+    int doc;
+    int line;
+} PostingCursor;
+
+int encodeVarint(unsigned char* out, unsigned int value);
+int decodeVarint(const unsigned char* in, unsigned int* value);
+
+int encodePosting(unsigned char* out, int lastDoc, int lastLine, int doc, int line);
+int decodePosting(const unsigned char* in, int* doc, int* line);
+
+void initPostingCursor(PostingCursor* cursor, const unsigned char* data, size_t size);
+int nextPosting(PostingCursor* cursor);
+
+#endif
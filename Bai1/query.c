@@ -0,0 +1,135 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+#include "posting.h"
+#include "binindex.h"
+#include "boolquery.h"
+#include "unicode.h"
+
+void printTerm(const BinIndex* index, const BinTerm* term) {
+    PostingCursor cursor;
+    initPostingCursor(&cursor, term->postings, term->postingSize);
+
+    printf("%s %u", term->word, term->count);
+    while (nextPosting(&cursor)) {
+        if (index->header->documentCount > 1) {
+            printf(",%d:%d", cursor.doc, cursor.line);
+        } else {
+            printf(",%d", cursor.line);
+        }
+    }
+    printf("\n");
+}
+
+double elapsedMicros(const struct timespec* start, const struct timespec* end) {
+    return (end->tv_sec - start->tv_sec) * 1e6 + (end->tv_nsec - start->tv_nsec) / 1e3;
+}
+
+/* In lan luot cac dong khop truy van, moi ket qua mot dong; limit <= 0 la khong gioi han */
+int runQuery(const BinIndex* index, const char* text, long limit) {
+    QuerySource* source = createQuerySource(index);
+    QueryNode* query = parseQuery(text, index, source);
+    if (!query) {
+        freeQuerySource(source);
+        return 0;
+    }
+
+    long printed = 0;
+    for (uint64_t key = nextQueryMatch(query); key != QUERY_END; key = nextQueryMatch(query)) {
+        if (index->header->documentCount > 1) {
+            printf("%d:%d\n", QUERY_DOC(key), QUERY_LINE(key));
+        } else {
+            printf("%d\n", QUERY_LINE(key));
+        }
+        if (++printed == limit) {
+            break;
+        }
+    }
+
+    freeQuery(query);
+    freeQuerySource(source);
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
+    int timing = 0;
+    const char* queryText = NULL;
+    long limit = 0;
+    int first = 1;
+
+    while (first < argc && argv[first][0] == '-' && argv[first][1] != '\0') {
+        if (strcmp(argv[first], "-t") == 0) {
+            timing = 1;
+            first++;
+        } else if (strcmp(argv[first], "-q") == 0 && first + 1 < argc) {
+            queryText = argv[first + 1];
+            first += 2;
+        } else if (strcmp(argv[first], "-n") == 0 && first + 1 < argc) {
+            limit = atol(argv[first + 1]);
+            first += 2;
+        } else {
+            break;
+        }
+    }
+    if ((queryText && argc - first != 1) || (!queryText && argc - first < 2)) {
+        fprintf(stderr, "Cach dung: %s [-t] <tep_chi_muc> <tu> [<tu> ...]\n", argv[0]);
+        fprintf(stderr, "           %s [-t] [-n K] -q \"truy_van\" <tep_chi_muc>\n", argv[0]);
+        return 1;
+    }
+
+    BinIndex index;
+    if (!openBinIndex(argv[first], &index)) {
+        return 1;
+    }
+
+    int utf8 = (index.header->flags & BIN_INDEX_UTF8) != 0;
+    if (utf8) {
+        initUnicodeTables();
+    }
+
+    if (queryText) {
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        int ok = runQuery(&index, queryText, limit);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        if (timing) {
+            fprintf(stderr, "truy van: %.1f us\n", elapsedMicros(&start, &end));
+        }
+        closeBinIndex(&index);
+        return ok ? 0 : 1;
+    }
+
+    for (int i = first + 1; i < argc; i++) {
+        char word[BIN_MAX_TERM_LEN];
+        if (utf8) {
+            foldUtf8Word(word, sizeof(word), argv[i], strlen(argv[i]));
+        } else {
+            size_t n = 0;
+            for (; argv[i][n] && n < sizeof(word) - 1; n++) {
+                word[n] = tolower((unsigned char)argv[i][n]);
+            }
+            word[n] = '\0';
+        }
+
+        BinTerm term;
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        int found = findBinTerm(&index, word, &term);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        if (found) {
+            printTerm(&index, &term);
+        } else {
+            printf("%s 0\n", word);
+        }
+        if (timing) {
+            fprintf(stderr, "%s: %.1f us\n", word, elapsedMicros(&start, &end));
+        }
+    }
+
+    closeBinIndex(&index);
+    return 0;
+}
@@ -0,0 +1,230 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "topk.h"
+
+#define MIN_PAIR_COUNTERS 16
+
+static void* checkedMalloc(size_t size) {
+    void* p = malloc(size);
+    if (!p) {
+        perror("Loi cap phat bo nho cho thong ke");
+        exit(1);
+    }
+    return p;
+}
+
+/******************* TopHeap ******************************/
+
+void initTopHeap(TopHeap* heap, int k, TopBefore before, const void* context) {
+    heap->items = (TopItem*)checkedMalloc((k > 0 ? k : 1) * sizeof(TopItem));
+    heap->size = 0;
+    heap->capacity = k;
+    heap->before = before;
+    heap->context = context;
+}
+
+/* Heap nguoc: cha kem hon (xep sau) cac con, goc la phan tu se bi loai dau tien */
+static void siftUpTop(TopHeap* heap, int i) {
+    TopItem item = heap->items[i];
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!heap->before(heap->context, &heap->items[parent], &item)) {
+            break;
+        }
+        heap->items[i] = heap->items[parent];
+        i = parent;
+    }
+    heap->items[i] = item;
+}
+
+static void siftDownTop(TopHeap* heap, int i, int size) {
+    TopItem item = heap->items[i];
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= size) {
+            break;
+        }
+        if (child + 1 < size && heap->before(heap->context, &heap->items[child], &heap->items[child + 1])) {
+            child++;
+        }
+        if (!heap->before(heap->context, &item, &heap->items[child])) {
+            break;
+        }
+        heap->items[i] = heap->items[child];
+        i = child;
+    }
+    heap->items[i] = item;
+}
+
+void offerTopHeap(TopHeap* heap, uint64_t count, int id) {
+    TopItem item;
+    item.count = count;
+    item.id = id;
+
+    if (heap->size < heap->capacity) {
+        heap->items[heap->size] = item;
+        siftUpTop(heap, heap->size++);
+    } else if (heap->capacity > 0 && heap->before(heap->context, &item, &heap->items[0])) {
+        heap->items[0] = item;
+        siftDownTop(heap, 0, heap->size);
+    }
+}
+
+void sortTopHeap(TopHeap* heap) {
+    /* Lay goc (kem nhat) ra cuoi mang, phan tu tot nhat con lai o dau */
+    for (int end = heap->size - 1; end > 0; end--) {
+        TopItem worst = heap->items[0];
+        heap->items[0] = heap->items[end];
+        heap->items[end] = worst;
+        siftDownTop(heap, 0, end);
+    }
+}
+
+void freeTopHeap(TopHeap* heap) {
+    free(heap->items);
+    heap->items = NULL;
+    heap->size = heap->capacity = 0;
+}
+
+/******************* PairCounter ******************************/
+
+static uint32_t hashPair(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xFF51AFD7ED558CCDull;
+    key ^= key >> 33;
+    key *= 0xC4CEB9FE1A85EC53ull;
+    key ^= key >> 33;
+    return (uint32_t)key;
+}
+
+void initPairCounter(PairCounter* counter, size_t budget) {
+    /* Moi bo dem: mot PairCount, mot o heap va hai o bang bam (bang luon con it nhat mot nua trong) */
+    size_t perCounter = sizeof(PairCount) + sizeof(int) + 2 * sizeof(int);
+    size_t capacity = budget / perCounter;
+    if (capacity < MIN_PAIR_COUNTERS) {
+        capacity = MIN_PAIR_COUNTERS;
+    }
+    if (capacity > (1u << 30)) {
+        capacity = 1u << 30;
+    }
+
+    uint32_t slotCount = 1;
+    while (slotCount < 2 * capacity) {
+        slotCount <<= 1;
+    }
+
+    counter->capacity = (int)capacity;
+    counter->count = 0;
+    counter->evictions = 0;
+    counter->mask = slotCount - 1;
+    counter->pairs = (PairCount*)checkedMalloc(capacity * sizeof(PairCount));
+    counter->heap = (int*)checkedMalloc(capacity * sizeof(int));
+    counter->slots = (int*)checkedMalloc(slotCount * sizeof(int));
+    memset(counter->slots, 0xFF, slotCount * sizeof(int));
+}
+
+static void swapPairHeap(PairCounter* counter, int a, int b) {
+    int pa = counter->heap[a];
+    int pb = counter->heap[b];
+    counter->heap[a] = pb;
+    counter->heap[b] = pa;
+    counter->pairs[pb].heapPos = a;
+    counter->pairs[pa].heapPos = b;
+}
+
+static void siftUpPair(PairCounter* counter, int i) {
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (counter->pairs[counter->heap[parent]].count <= counter->pairs[counter->heap[i]].count) {
+            break;
+        }
+        swapPairHeap(counter, i, parent);
+        i = parent;
+    }
+}
+
+/* So dem chi tang, nen bo dem vua tang chi can di xuong */
+static void siftDownPair(PairCounter* counter, int i) {
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= counter->count) {
+            break;
+        }
+        if (child + 1 < counter->count &&
+            counter->pairs[counter->heap[child + 1]].count < counter->pairs[counter->heap[child]].count) {
+            child++;
+        }
+        if (counter->pairs[counter->heap[i]].count <= counter->pairs[counter->heap[child]].count) {
+            break;
+        }
+        swapPairHeap(counter, i, child);
+        i = child;
+    }
+}
+
+static uint32_t findPairSlot(const PairCounter* counter, uint64_t key) {
+    uint32_t slot = hashPair(key) & counter->mask;
+    while (counter->slots[slot] >= 0 && counter->pairs[counter->slots[slot]].key != key) {
+        slot = (slot + 1) & counter->mask;
+    }
+    return slot;
+}
+
+/* Xoa bang cach doi lui cac o phia sau, khong can danh dau o da xoa */
+static void removePairSlot(PairCounter* counter, uint32_t slot) {
+    uint32_t hole = slot;
+    uint32_t next = (slot + 1) & counter->mask;
+    while (counter->slots[next] >= 0) {
+        uint32_t home = hashPair(counter->pairs[counter->slots[next]].key) & counter->mask;
+        /* Chuyen ve lo trong neu o goc cua no khong nam trong (hole, next] */
+        if (((next - home) & counter->mask) >= ((next - hole) & counter->mask)) {
+            counter->slots[hole] = counter->slots[next];
+            hole = next;
+        }
+        next = (next + 1) & counter->mask;
+    }
+    counter->slots[hole] = -1;
+}
+
+void countPair(PairCounter* counter, uint64_t key) {
+    uint32_t slot = findPairSlot(counter, key);
+    if (counter->slots[slot] >= 0) {
+        PairCount* pair = &counter->pairs[counter->slots[slot]];
+        pair->count++;
+        siftDownPair(counter, pair->heapPos);
+        return;
+    }
+
+    if (counter->count < counter->capacity) {
+        int index = counter->count++;
+        PairCount* pair = &counter->pairs[index];
+        pair->key = key;
+        pair->count = 1;
+        pair->error = 0;
+        pair->heapPos = index;
+        counter->heap[index] = index;
+        counter->slots[slot] = index;
+        siftUpPair(counter, index);
+        return;
+    }
+
+    /* Het bo dem: cap moi thay cho cap co so dem nho nhat */
+    int index = counter->heap[0];
+    PairCount* pair = &counter->pairs[index];
+    removePairSlot(counter, findPairSlot(counter, pair->key));
+    pair->key = key;
+    pair->error = pair->count;
+    pair->count++;
+    counter->slots[findPairSlot(counter, key)] = index;
+    siftDownPair(counter, 0);
+    counter->evictions++;
+}
+
+void freePairCounter(PairCounter* counter) {
+    free(counter->pairs);
+    free(counter->heap);
+    free(counter->slots);
+    memset(counter, 0, sizeof(*counter));
+}
@@ -0,0 +1,62 @@
+#ifndef __TOPK_H__
+#define __TOPK_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Thong ke tan suat cho che do -k.
+ *
+ * TopHeap giu K phan tu tot nhat da thay bang mot heap K phan tu: goc la phan tu kem nhat,
+ * phan tu moi chi vao heap khi tot hon goc. Thu tu "tot hon" do nguoi goi quyet dinh.
+ *
+ * PairCounter dem cap tu lien tiep voi so bo dem co dinh (thuat toan Space-Saving):
+ * khi het bo dem, cap moi thay cho cap co so dem nho nhat va ke thua so dem do. Moi cap
+ * co count >= so lan xuat hien that >= count - error, va moi cap xuat hien nhieu hon
+ * (tong so cap / so bo dem) lan chac chan con trong bang.
+ */
+
+typedef struct {
+    uint64_t count;
+    int id;
+} TopItem;
+
+/* Khac 0 neu a xep truoc b trong ket qua */
+typedef int (*TopBefore)(const void* context, const TopItem* a, const TopItem* b);
+
+typedef struct {
+    TopItem* items;
+    int size;
+    int capacity;
+    TopBefore before;
+    const void* context;
+} TopHeap;
+
+void initTopHeap(TopHeap* heap, int k, TopBefore before, const void* context);
+void offerTopHeap(TopHeap* heap, uint64_t count, int id);
+/* Sap items[0..size) theo thu tu ket qua; sau do khong offer duoc nua */
+void sortTopHeap(TopHeap* heap);
+void freeTopHeap(TopHeap* heap);
+
+typedef struct {
+    uint64_t key;
+    uint64_t count;
+    uint64_t error;     /* so dem ke thua khi thay cap khac */
+    int heapPos;
+} PairCount;
+
+typedef struct {
+    PairCount* pairs;
+    int count;
+    int capacity;       /* so bo dem toi da, tinh tu ngan sach bo nho */
+    int* heap;          /* min-heap theo count, chua chi so vao pairs */
+    int* slots;         /* bang bam do tuyen tinh, -1 neu trong */
+    uint32_t mask;
+    uint64_t evictions;
+} PairCounter;
+
+void initPairCounter(PairCounter* counter, size_t budget);
+void countPair(PairCounter* counter, uint64_t key);
+void freePairCounter(PairCounter* counter);
+
+#endif
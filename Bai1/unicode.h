@@ -0,0 +1,33 @@
+#ifndef __UNICODE_H__
+#define __UNICODE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Phan loai ky tu Unicode va chu thuong don cho che do UTF-8 (-U). Bang tra cuu duoc dung
+ * mot lan tu cac khoang trong unicode.c (initUnicodeTables), sau do moi ky tu trong BMP chi
+ * ton mot phep tra bit va mot phep tra bang hai tang; ky tu ngoai BMP tim nhi phan tren khoang.
+ */
+
+#define UNI_OTHER 0
+#define UNI_LETTER 1
+#define UNI_SPACE 2         /* khoang trang Unicode, khong doi trang thai dau cau */
+#define UNI_SENTENCE 3      /* dau ket thuc cau ngoai ASCII: '…', '。', '！', '？' ... */
+
+#define UNI_REPLACEMENT 0xFFFD
+
+void initUnicodeTables(void);
+
+/* So byte cua ky tu dau p[0..n) va ma cua no; 0 neu day byte hop le nhung bi cat, -1 neu p[0] khong hop le */
+int decodeUtf8(const unsigned char* p, size_t n, uint32_t* cp);
+int encodeUtf8(uint32_t cp, unsigned char* out);
+
+int unicodeClass(uint32_t cp);
+uint32_t foldCase(uint32_t cp);
+int isUnicodeUpper(uint32_t cp);
+
+/* Chep src[0..len) sang dst da doi chu thuong, cat o bien ky tu de vua dstSize (ke ca '\0') */
+size_t foldUtf8Word(char* dst, size_t dstSize, const char* src, size_t len);
+
+#endif
@@ -0,0 +1,344 @@
+/*
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "reader.h"
+#include "parser.h"
+#include "batch.h"
+
+#define MAX_THREADS 256
+
+enum JobStatus {
+  JOB_COMPILED,
+  JOB_FAILED,
+  JOB_UNREADABLE,
+  JOB_UNWRITABLE
+};
+
+typedef struct {
+  char *source;
+  char *output;
+  enum JobStatus status;
+  CompileResult result;
+} Job;
+
+typedef struct {
+  Job *jobs;
+  int count;
+  int capacity;
+  int next;                 // first job not yet taken by a worker
+  pthread_mutex_t lock;
+} JobQueue;
+
+static void *checkedMalloc(size_t size) {
+  void *p = malloc(size);
+  if (p == NULL) {
+    fprintf(stderr, "batch: out of memory\n");
+    exit(1);
+  }
+  return p;
+}
+
+static char *joinPath(const char *dir, const char *name, const char *suffix) {
+  size_t dirLen = strlen(dir);
+  char *path = (char*) checkedMalloc(dirLen + strlen(name) + strlen(suffix) + 2);
+
+  if (dirLen == 0)
+    sprintf(path, "%s%s", name, suffix);
+  else if (dir[dirLen - 1] == '/')
+    sprintf(path, "%s%s%s", dir, name, suffix);
+  else sprintf(path, "%s/%s%s", dir, name, suffix);
+  return path;
+}
+
+static void addJob(JobQueue *queue, const char *source, const char *outDir) {
+  Job *job;
+
+  if (queue->count == queue->capacity) {
+    queue->capacity = queue->capacity ? 2 * queue->capacity : 64;
+    queue->jobs = (Job*) realloc(queue->jobs, queue->capacity * sizeof(Job));
+    if (queue->jobs == NULL) {
+      fprintf(stderr, "batch: out of memory\n");
+      exit(1);
+    }
+  }
+
+  job = &queue->jobs[queue->count++];
+  job->source = joinPath("", source, "");
+  if (outDir == NULL)
+    job->output = joinPath("", source, ".out");
+  else {
+    const char *base = strrchr(source, '/');
+    job->output = joinPath(outDir, base != NULL ? base + 1 : source, ".out");
+  }
+  job->status = JOB_COMPILED;
+}
+
+static int hasKplSuffix(const char *name) {
+  size_t len = strlen(name);
+  return len > 4 && strcmp(name + len - 4, ".kpl") == 0;
+}
+
+static int compareNames(const void *a, const void *b) {
+  return strcmp(*(char * const *) a, *(char * const *) b);
+}
+
+static int compareOutputs(const void *a, const void *b) {
+  return strcmp((*(Job * const *) a)->output, (*(Job * const *) b)->output);
+}
+
+// Two jobs writing the same file would race; report every clash
+static int checkOutputs(JobQueue *queue) {
+  Job **sorted;
+  int i, ok = 1;
+
+  if (queue->count < 2)
+    return 1;
+
+  sorted = (Job**) checkedMalloc(queue->count * sizeof(Job*));
+  for (i = 0; i < queue->count; i++)
+    sorted[i] = &queue->jobs[i];
+  qsort(sorted, queue->count, sizeof(Job*), compareOutputs);
+
+  for (i = 1; i < queue->count; i++)
+    if (strcmp(sorted[i - 1]->output, sorted[i]->output) == 0) {
+      printf("batch: %s and %s both write %s\n",
+             sorted[i - 1]->source, sorted[i]->source, sorted[i]->output);
+      ok = 0;
+    }
+  free(sorted);
+  return ok;
+}
+
+// Every *.kpl file directly inside dir, in name order
+static int addDirectory(JobQueue *queue, const char *dir, const char *outDir) {
+  DIR *d = opendir(dir);
+  struct dirent *entry;
+  char **names = NULL;
+  int count = 0, capacity = 0, i;
+
+  if (d == NULL)
+    return 0;
+
+  while ((entry = readdir(d)) != NULL) {
+    if (!hasKplSuffix(entry->d_name))
+      continue;
+    if (count == capacity) {
+      capacity = capacity ? 2 * capacity : 64;
+      names = (char**) realloc(names, capacity * sizeof(char*));
+      if (names == NULL) {
+        fprintf(stderr, "batch: out of memory\n");
+        exit(1);
+      }
+    }
+    names[count++] = joinPath(dir, entry->d_name, "");
+  }
+  closedir(d);
+
+  qsort(names, count, sizeof(char*), compareNames);
+  for (i = 0; i < count; i++) {
+    addJob(queue, names[i], outDir);
+    free(names[i]);
+  }
+  free(names);
+  return 1;
+}
+
+// One path per line; blank lines and lines starting with '#' are skipped
+static int addListFile(JobQueue *queue, const char *listFile, const char *outDir) {
+  FILE *f = fopen(listFile, "rt");
+  char *line = NULL;
+  size_t size = 0;
+
+  if (f == NULL)
+    return 0;
+
+  while (getline(&line, &size, f) != -1) {
+    char *start = line;
+    size_t len;
+
+    while (*start == ' ' || *start == '\t')
+      start++;
+    len = strlen(start);
+    while (len > 0 && (start[len - 1] == '\n' || start[len - 1] == '\r' ||
+                       start[len - 1] == ' ' || start[len - 1] == '\t'))
+      start[--len] = '\0';
+    if (len == 0 || start[0] == '#')
+      continue;
+    addJob(queue, start, outDir);
+  }
+  free(line);
+  fclose(f);
+  return 1;
+}
+
+static void runJob(Job *job) {
+  FILE *output = fopen(job->output, "w");
+
+  if (output == NULL) {
+    job->status = JOB_UNWRITABLE;
+    return;
+  }
+
+  if (compileFile(job->source, output, &job->result) == IO_ERROR) {
+    fclose(output);
+    remove(job->output);
+    job->status = JOB_UNREADABLE;
+    return;
+  }
+
+  fclose(output);
+  job->status = job->result.failed ? JOB_FAILED : JOB_COMPILED;
+}
+
+static void *worker(void *arg) {
+  JobQueue *queue = (JobQueue*) arg;
+
+  for (;;) {
+    int index;
+
+    pthread_mutex_lock(&queue->lock);
+    index = queue->next++;
+    pthread_mutex_unlock(&queue->lock);
+
+    if (index >= queue->count)
+      break;
+    runJob(&queue->jobs[index]);
+  }
+  return NULL;
+}
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int defaultThreads(void) {
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  if (n < 1) return 1;
+  if (n > MAX_THREADS) return MAX_THREADS;
+  return (int) n;
+}
+
+static void usage(void) {
+  printf("usage: kplc --batch [-j threads] [-o dir] <list file | directory> ...\n");
+}
+
+int runBatch(int argc, char *argv[]) {
+  JobQueue queue;
+  pthread_t threads[MAX_THREADS];
+  const char *outDir = NULL;
+  int threadCount = defaultThreads();
+  int compiled = 0, failed = 0, unreadable = 0;
+  long lines = 0;
+  double start, elapsed;
+  struct stat st;
+  int i;
+
+  memset(&queue, 0, sizeof(queue));
+
+  for (i = 0; i < argc; i++) {
+    if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+      threadCount = atoi(argv[++i]);
+      if (threadCount < 1 || threadCount > MAX_THREADS) {
+        printf("batch: thread count must be between 1 and %d.\n", MAX_THREADS);
+        return -1;
+      }
+    } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+      outDir = argv[++i];
+    } else if (argv[i][0] == '-') {
+      usage();
+      return -1;
+    } else break;
+  }
+
+  if (i == argc) {
+    usage();
+    return -1;
+  }
+
+  for (; i < argc; i++) {
+    int ok;
+    if (stat(argv[i], &st) == 0 && S_ISDIR(st.st_mode))
+      ok = addDirectory(&queue, argv[i], outDir);
+    else ok = addListFile(&queue, argv[i], outDir);
+    if (!ok) {
+      printf("Can\'t read %s!\n", argv[i]);
+      return -1;
+    }
+  }
+
+  if (!checkOutputs(&queue))
+    return -1;
+
+  if (threadCount > queue.count)
+    threadCount = queue.count > 0 ? queue.count : 1;
+
+  pthread_mutex_init(&queue.lock, NULL);
+  start = now();
+  // Carry on with however many workers could be started
+  for (i = 0; i < threadCount; i++)
+    if (pthread_create(&threads[i], NULL, worker, &queue) != 0)
+      break;
+  if (i < threadCount) {
+    fprintf(stderr, "batch: could only start %d of %d threads\n", i, threadCount);
+    threadCount = i;
+  }
+  if (threadCount == 0) {
+    pthread_mutex_destroy(&queue.lock);
+    return -1;
+  }
+  for (i = 0; i < threadCount; i++)
+    pthread_join(threads[i], NULL);
+  elapsed = now() - start;
+  pthread_mutex_destroy(&queue.lock);
+
+  // Per-file problems in input order, then the totals
+  for (i = 0; i < queue.count; i++) {
+    Job *job = &queue.jobs[i];
+
+    switch (job->status) {
+    case JOB_COMPILED:
+      compiled++;
+      lines += job->result.lines;
+      break;
+    case JOB_FAILED:
+      failed++;
+      lines += job->result.lines;
+      printf("%s:%d-%d:%s\n", job->source, job->result.lineNo, job->result.colNo, job->result.message);
+      break;
+    case JOB_UNREADABLE:
+      unreadable++;
+      printf("%s: can\'t read input file\n", job->source);
+      break;
+    case JOB_UNWRITABLE:
+      unreadable++;
+      printf("%s: can\'t write %s\n", job->source, job->output);
+      break;
+    }
+    free(job->source);
+    free(job->output);
+  }
+  free(queue.jobs);
+
+  printf("%d files: %d compiled, %d with errors, %d not processed\n",
+         queue.count, compiled, failed, unreadable);
+  printf("%.3f s on %d thread%s: %.1f files/s, %.1f lines/s\n", elapsed, threadCount,
+         threadCount == 1 ? "" : "s",
+         elapsed > 0 ? (compiled + failed) / elapsed : 0.0,
+         elapsed > 0 ? lines / elapsed : 0.0);
+
+  return unreadable == 0 ? 0 : 1;
+}
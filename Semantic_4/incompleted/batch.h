@@ -0,0 +1,13 @@
+/*
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+#ifndef __BATCH_H__
+#define __BATCH_H__
+
+// kplc --batch [-j threads] [-o dir] <list file | directory> ...
+int runBatch(int argc, char *argv[]);
+
+#endif
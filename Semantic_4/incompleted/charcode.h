@@ -26,7 +26,10 @@ typedef enum {
   CHAR_SINGLEQUOTE,
   CHAR_LPAR,
   CHAR_RPAR,
-  CHAR_UNKNOWN
+  CHAR_UNKNOWN,
+  CHAR_EOF            // class of EOF in the scanner's DFA; no byte maps to it
 } CharCode;
 
+#define CHAR_CLASSES (CHAR_EOF + 1)
+
 #endif
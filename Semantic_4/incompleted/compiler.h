@@ -0,0 +1,42 @@
+/* 
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+#ifndef __COMPILER_H__
+#define __COMPILER_H__
+
+#include <stdio.h>
+#include <setjmp.h>
+#include "reader.h"
+#include "token.h"
+#include "symtab.h"
+#include "names.h"
+
+#define MAX_MESSAGE_LEN 128
+
+// Outcome of one compilation, filled in by compileFile()
+typedef struct {
+  int lines;                          // source lines read
+  int failed;                         // a diagnostic was reported
+  int lineNo, colNo;                  // position of that diagnostic
+  char message[MAX_MESSAGE_LEN];
+} CompileResult;
+
+// Everything one compilation reads and writes. The stages share no other
+// mutable state, so compile() may run on different files in parallel threads.
+typedef struct {
+  Reader reader;
+  Token tokens[2];                    // the scanner writes into these, nothing is allocated per token
+  Token *currentToken;                // each points at one of tokens[]
+  Token *lookAhead;
+  SymTab* symtab;
+  Object* pending;                    // created but not yet declared, freed if error() abandons it
+  NameTable names;                    // identifiers, shared by scanner and symbol table
+  FILE *output;                       // symbol table dump and diagnostics
+  jmp_buf errorJump;                  // error() abandons the compilation here
+  CompileResult result;
+} Compiler;
+
+#endif
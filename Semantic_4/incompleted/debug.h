@@ -7,12 +7,13 @@
 #ifndef __DEBUG_H__
 #define __DEBUG_H_
 
+#include <stdio.h>
 #include "symtab.h"
 
-void printType(Type* type);
-void printConstantValue(ConstantValue* value);
-void printObject(Object* obj, int indent);
-void printObjectList(ObjectNode* objList, int indent);
-void printScope(Scope* scope, int indent);
+void printType(FILE* out, Type* type);
+void printConstantValue(FILE* out, ConstantValue* value);
+void printObject(FILE* out, Object* obj, int indent);
+void printObjectList(FILE* out, ObjectNode* objList, int indent);
+void printScope(FILE* out, Scope* scope, int indent);
 
 #endif
@@ -6,18 +6,20 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <setjmp.h>
 #include "error.h"
 
-#define NUM_OF_ERRORS 29
+#define NUM_OF_ERRORS 30
 
 struct ErrorMessage {
   ErrorCode errorCode;
   char *message;
 };
 
-struct ErrorMessage errors[29] = {
+struct ErrorMessage errors[30] = {
   {ERR_END_OF_COMMENT, "End of comment expected."},
   {ERR_IDENT_TOO_LONG, "Identifier too long."},
+  {ERR_NUMBER_TOO_LONG, "Number too long."},
   {ERR_INVALID_CONSTANT_CHAR, "Invalid char constant."},
   {ERR_INVALID_SYMBOL, "Invalid symbol."},
   {ERR_INVALID_IDENT, "An identifier expected."},
@@ -47,18 +49,28 @@ struct ErrorMessage errors[29] = {
   {ERR_PARAMETERS_ARGUMENTS_INCONSISTENCY, "The number of arguments and the number of parameters are inconsistent."}
 };
 
-void error(ErrorCode err, int lineNo, int colNo) {
+static void abortCompilation(Compiler* compiler, int lineNo, int colNo) {
+  CompileResult* result = &compiler->result;
+
+  result->failed = 1;
+  result->lineNo = lineNo;
+  result->colNo = colNo;
+  fprintf(compiler->output, "%d-%d:%s\n", lineNo, colNo, result->message);
+  longjmp(compiler->errorJump, 1);
+}
+
+void error(Compiler* compiler, ErrorCode err, int lineNo, int colNo) {
   int i;
   for (i = 0 ; i < NUM_OF_ERRORS; i ++) 
     if (errors[i].errorCode == err) {
-      printf("%d-%d:%s\n", lineNo, colNo, errors[i].message);
-      exit(0);
+      snprintf(compiler->result.message, MAX_MESSAGE_LEN, "%s", errors[i].message);
+      abortCompilation(compiler, lineNo, colNo);
     }
 }
 
-void missingToken(TokenType tokenType, int lineNo, int colNo) {
-  printf("%d-%d:Missing %s\n", lineNo, colNo, tokenToString(tokenType));
-  exit(0);
+void missingToken(Compiler* compiler, TokenType tokenType, int lineNo, int colNo) {
+  snprintf(compiler->result.message, MAX_MESSAGE_LEN, "Missing %s", tokenToString(tokenType));
+  abortCompilation(compiler, lineNo, colNo);
 }
 
 void assert(char *msg) {
@@ -6,11 +6,12 @@
 
 #ifndef __ERROR_H__
 #define __ERROR_H__
-#include "token.h"
+#include "compiler.h"
 
 typedef enum {
   ERR_END_OF_COMMENT,
   ERR_IDENT_TOO_LONG,
+  ERR_NUMBER_TOO_LONG,
   ERR_INVALID_CONSTANT_CHAR,
   ERR_INVALID_SYMBOL,
   ERR_INVALID_IDENT,
@@ -40,8 +41,9 @@ typedef enum {
   ERR_PARAMETERS_ARGUMENTS_INCONSISTENCY
 } ErrorCode;
 
-void error(ErrorCode err, int lineNo, int colNo);
-void missingToken(TokenType tokenType, int lineNo, int colNo);
+// Both report the diagnostic and jump back to compileFile(); they never return
+void error(Compiler* compiler, ErrorCode err, int lineNo, int colNo);
+void missingToken(Compiler* compiler, TokenType tokenType, int lineNo, int colNo);
 void assert(char *msg);
 
 #endif
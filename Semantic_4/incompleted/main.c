@@ -6,9 +6,11 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "reader.h"
 #include "parser.h"
+#include "batch.h"
 
 /******************************************************************/
 
@@ -18,6 +20,9 @@ int main(int argc, char *argv[]) {
     return -1;
   }
 
+  if (strcmp(argv[1], "--batch") == 0)
+    return runBatch(argc - 2, argv + 2);
+
   if (compile(argv[1]) == IO_ERROR) {
     printf("Can\'t read input file!\n");
     return -1;
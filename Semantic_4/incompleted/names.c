@@ -0,0 +1,105 @@
+/* 
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "names.h"
+
+#define INITIAL_NAME_SLOTS 256
+
+static unsigned int hashName(const char *name, int length) {
+  unsigned int hash = 2166136261u;
+  int i;
+
+  for (i = 0; i < length; i++) {
+    hash ^= (unsigned char) name[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static NameSlot* allocateSlots(int capacity) {
+  return (NameSlot*) calloc(capacity, sizeof(NameSlot));
+}
+
+void initNameTable(NameTable *table) {
+  table->capacity = INITIAL_NAME_SLOTS;
+  table->count = 0;
+  table->slots = allocateSlots(table->capacity);
+  table->blocks = NULL;
+}
+
+void freeNameTable(NameTable *table) {
+  NameBlock *block = table->blocks;
+
+  while (block != NULL) {
+    NameBlock *next = block->next;
+    free(block);
+    block = next;
+  }
+  free(table->slots);
+  table->slots = NULL;
+  table->blocks = NULL;
+  table->capacity = table->count = 0;
+}
+
+static char* storeName(NameTable *table, const char *name, int length) {
+  NameBlock *block = table->blocks;
+  char *copy;
+
+  if ((block == NULL) || (block->used + length + 1 > NAME_BLOCK_SIZE)) {
+    block = (NameBlock*) malloc(sizeof(NameBlock));
+    block->next = table->blocks;
+    block->used = 0;
+    table->blocks = block;
+  }
+
+  copy = block->text + block->used;
+  memcpy(copy, name, length);
+  copy[length] = '\0';
+  block->used += length + 1;
+  return copy;
+}
+
+// Keep the table at most half full so probe sequences stay short
+static void growNameTable(NameTable *table) {
+  NameSlot *old = table->slots;
+  int oldCapacity = table->capacity;
+  int i;
+
+  table->capacity *= 2;
+  table->slots = allocateSlots(table->capacity);
+  for (i = 0; i < oldCapacity; i++)
+    if (old[i].name != NULL) {
+      int slot = old[i].hash & (table->capacity - 1);
+      while (table->slots[slot].name != NULL)
+        slot = (slot + 1) & (table->capacity - 1);
+      table->slots[slot] = old[i];
+    }
+  free(old);
+}
+
+char* internName(NameTable *table, const char *name, int length) {
+  unsigned int hash = hashName(name, length);
+  int slot = hash & (table->capacity - 1);
+
+  while (table->slots[slot].name != NULL) {
+    NameSlot *s = &table->slots[slot];
+    if ((s->hash == hash) && (strncmp(s->name, name, length) == 0) && (s->name[length] == '\0'))
+      return s->name;
+    slot = (slot + 1) & (table->capacity - 1);
+  }
+
+  table->slots[slot].hash = hash;
+  table->slots[slot].name = storeName(table, name, length);
+  table->count++;
+  if (2 * table->count > table->capacity) {
+    char *interned = table->slots[slot].name;
+    growNameTable(table);
+    return interned;
+  }
+  return table->slots[slot].name;
+}
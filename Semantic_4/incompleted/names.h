@@ -0,0 +1,41 @@
+/* 
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+#ifndef __NAMES_H__
+#define __NAMES_H__
+
+#define NAME_BLOCK_SIZE 4096
+
+// Storage for interned names, released all at once with the table
+struct NameBlock_ {
+  struct NameBlock_ *next;
+  int used;
+  char text[NAME_BLOCK_SIZE];
+};
+
+typedef struct NameBlock_ NameBlock;
+
+typedef struct {
+  unsigned int hash;
+  char *name;                         // NULL for an empty slot
+} NameSlot;
+
+// Every distinct identifier of one compilation, stored once. Interned names
+// are equal exactly when their pointers are, so they compare with ==.
+typedef struct {
+  NameSlot *slots;
+  int capacity;                       // a power of two
+  int count;
+  NameBlock *blocks;
+} NameTable;
+
+void initNameTable(NameTable *table);
+void freeNameTable(NameTable *table);
+
+// The interned copy of name[0..length)
+char* internName(NameTable *table, const char *name, int length);
+
+#endif
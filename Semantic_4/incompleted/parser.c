@@ -1,5 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
 
 #include "reader.h"
 #include "scanner.h"
@@ -8,411 +10,413 @@
 #include "error.h"
 #include "debug.h"
 
-Token *currentToken;
-Token *lookAhead;
+void scan(Compiler* compiler) {
+  Token* next = compiler->currentToken;
 
-extern Type* intType;
-extern Type* charType;
-extern SymTab* symtab;
-
-void scan(void) {
-  Token* tmp = currentToken;
-  currentToken = lookAhead;
-  lookAhead = getValidToken();
-  free(tmp);
+  // The old current token is dead, its slot receives the new look ahead
+  compiler->currentToken = compiler->lookAhead;
+  compiler->lookAhead = getValidToken(compiler, next);
 }
 
-void eat(TokenType tokenType) {
-  if (lookAhead->tokenType == tokenType) {
-    scan();
-  } else missingToken(tokenType, lookAhead->lineNo, lookAhead->colNo);
+void eat(Compiler* compiler, TokenType tokenType) {
+  if (compiler->lookAhead->tokenType == tokenType) {
+    scan(compiler);
+  } else missingToken(compiler, tokenType, compiler->lookAhead->lineNo, compiler->lookAhead->colNo);
 }
 
-void compileProgram(void) {
+void compileProgram(Compiler* compiler) {
   Object* program;
 
-  eat(KW_PROGRAM);
-  eat(TK_IDENT);
+  eat(compiler, KW_PROGRAM);
+  eat(compiler, TK_IDENT);
 
-  program = createProgramObject(currentToken->string);
-  enterBlock(program->progAttrs->scope);
+  program = createProgramObject(compiler->symtab, compiler->currentToken->name);
+  enterBlock(compiler->symtab, program->progAttrs->scope);
 
-  eat(SB_SEMICOLON);
+  eat(compiler, SB_SEMICOLON);
 
-  compileBlock();
-  eat(SB_PERIOD);
+  compileBlock(compiler);
+  eat(compiler, SB_PERIOD);
 
-  exitBlock();
+  exitBlock(compiler->symtab);
 }
 
-void compileBlock(void) {
+void compileBlock(Compiler* compiler) {
   Object* constObj;
   ConstantValue* constValue;
 
-  if (lookAhead->tokenType == KW_CONST) {
-    eat(KW_CONST);
+  if (compiler->lookAhead->tokenType == KW_CONST) {
+    eat(compiler, KW_CONST);
 
     do {
-      eat(TK_IDENT);
+      eat(compiler, TK_IDENT);
       
-      checkFreshIdent(currentToken->string);
-      constObj = createConstantObject(currentToken->string);
+      checkFreshIdent(compiler, compiler->currentToken->name);
+      constObj = createConstantObject(compiler->currentToken->name);
+      compiler->pending = constObj;
       
-      eat(SB_EQ);
-      constValue = compileConstant();
+      eat(compiler, SB_EQ);
+      constValue = compileConstant(compiler);
       
       constObj->constAttrs->value = constValue;
-      declareObject(constObj);
+      declareObject(compiler->symtab, constObj);
+      compiler->pending = NULL;
       
-      eat(SB_SEMICOLON);
-    } while (lookAhead->tokenType == TK_IDENT);
+      eat(compiler, SB_SEMICOLON);
+    } while (compiler->lookAhead->tokenType == TK_IDENT);
 
-    compileBlock2();
+    compileBlock2(compiler);
   } 
-  else compileBlock2();
+  else compileBlock2(compiler);
 }
 
-void compileBlock2(void) {
+void compileBlock2(Compiler* compiler) {
   Object* typeObj;
   Type* actualType;
 
-  if (lookAhead->tokenType == KW_TYPE) {
-    eat(KW_TYPE);
+  if (compiler->lookAhead->tokenType == KW_TYPE) {
+    eat(compiler, KW_TYPE);
 
     do {
-      eat(TK_IDENT);
+      eat(compiler, TK_IDENT);
       
-      checkFreshIdent(currentToken->string);
-      typeObj = createTypeObject(currentToken->string);
+      checkFreshIdent(compiler, compiler->currentToken->name);
+      typeObj = createTypeObject(compiler->currentToken->name);
+      compiler->pending = typeObj;
       
-      eat(SB_EQ);
-      actualType = compileType();
+      eat(compiler, SB_EQ);
+      actualType = compileType(compiler);
       
       typeObj->typeAttrs->actualType = actualType;
-      declareObject(typeObj);
+      declareObject(compiler->symtab, typeObj);
+      compiler->pending = NULL;
       
-      eat(SB_SEMICOLON);
-    } while (lookAhead->tokenType == TK_IDENT);
+      eat(compiler, SB_SEMICOLON);
+    } while (compiler->lookAhead->tokenType == TK_IDENT);
 
-    compileBlock3();
+    compileBlock3(compiler);
   } 
-  else compileBlock3();
+  else compileBlock3(compiler);
 }
 
-void compileBlock3(void) {
+void compileBlock3(Compiler* compiler) {
   Object* varObj;
   Type* varType;
 
-  if (lookAhead->tokenType == KW_VAR) {
-    eat(KW_VAR);
+  if (compiler->lookAhead->tokenType == KW_VAR) {
+    eat(compiler, KW_VAR);
 
     do {
-      eat(TK_IDENT);
+      eat(compiler, TK_IDENT);
       
-      checkFreshIdent(currentToken->string);
-      varObj = createVariableObject(currentToken->string);
+      checkFreshIdent(compiler, compiler->currentToken->name);
+      varObj = createVariableObject(compiler->symtab, compiler->currentToken->name);
+      compiler->pending = varObj;
 
-      eat(SB_COLON);
-      varType = compileType();
+      eat(compiler, SB_COLON);
+      varType = compileType(compiler);
       
       varObj->varAttrs->type = varType;
-      declareObject(varObj);
+      declareObject(compiler->symtab, varObj);
+      compiler->pending = NULL;
       
-      eat(SB_SEMICOLON);
-    } while (lookAhead->tokenType == TK_IDENT);
+      eat(compiler, SB_SEMICOLON);
+    } while (compiler->lookAhead->tokenType == TK_IDENT);
 
-    compileBlock4();
+    compileBlock4(compiler);
   } 
-  else compileBlock4();
+  else compileBlock4(compiler);
 }
 
-void compileBlock4(void) {
-  compileSubDecls();
-  compileBlock5();
+void compileBlock4(Compiler* compiler) {
+  compileSubDecls(compiler);
+  compileBlock5(compiler);
 }
 
-void compileBlock5(void) {
-  eat(KW_BEGIN);
-  compileStatements();
-  eat(KW_END);
+void compileBlock5(Compiler* compiler) {
+  eat(compiler, KW_BEGIN);
+  compileStatements(compiler);
+  eat(compiler, KW_END);
 }
 
-void compileSubDecls(void) {
-  while ((lookAhead->tokenType == KW_FUNCTION) || (lookAhead->tokenType == KW_PROCEDURE)) {
-    if (lookAhead->tokenType == KW_FUNCTION)
-      compileFuncDecl();
-    else compileProcDecl();
+void compileSubDecls(Compiler* compiler) {
+  while ((compiler->lookAhead->tokenType == KW_FUNCTION) || (compiler->lookAhead->tokenType == KW_PROCEDURE)) {
+    if (compiler->lookAhead->tokenType == KW_FUNCTION)
+      compileFuncDecl(compiler);
+    else compileProcDecl(compiler);
   }
 }
 
-void compileFuncDecl(void) {
+void compileFuncDecl(Compiler* compiler) {
   Object* funcObj;
   Type* returnType;
 
-  eat(KW_FUNCTION);
-  eat(TK_IDENT);
+  eat(compiler, KW_FUNCTION);
+  eat(compiler, TK_IDENT);
 
-  checkFreshIdent(currentToken->string);
-  funcObj = createFunctionObject(currentToken->string);
-  declareObject(funcObj);
+  checkFreshIdent(compiler, compiler->currentToken->name);
+  funcObj = createFunctionObject(compiler->symtab, compiler->currentToken->name);
+  declareObject(compiler->symtab, funcObj);
 
-  enterBlock(funcObj->funcAttrs->scope);
+  enterBlock(compiler->symtab, funcObj->funcAttrs->scope);
   
-  compileParams();
+  compileParams(compiler);
 
-  eat(SB_COLON);
-  returnType = compileBasicType();
+  eat(compiler, SB_COLON);
+  returnType = compileBasicType(compiler);
   funcObj->funcAttrs->returnType = returnType;
 
-  eat(SB_SEMICOLON);
-  compileBlock();
-  eat(SB_SEMICOLON);
+  eat(compiler, SB_SEMICOLON);
+  compileBlock(compiler);
+  eat(compiler, SB_SEMICOLON);
 
-  exitBlock();
+  exitBlock(compiler->symtab);
 }
 
-void compileProcDecl(void) {
+void compileProcDecl(Compiler* compiler) {
   Object* procObj;
 
-  eat(KW_PROCEDURE);
-  eat(TK_IDENT);
+  eat(compiler, KW_PROCEDURE);
+  eat(compiler, TK_IDENT);
 
-  checkFreshIdent(currentToken->string);
-  procObj = createProcedureObject(currentToken->string);
-  declareObject(procObj);
+  checkFreshIdent(compiler, compiler->currentToken->name);
+  procObj = createProcedureObject(compiler->symtab, compiler->currentToken->name);
+  declareObject(compiler->symtab, procObj);
 
-  enterBlock(procObj->procAttrs->scope);
+  enterBlock(compiler->symtab, procObj->procAttrs->scope);
 
-  compileParams();
+  compileParams(compiler);
 
-  eat(SB_SEMICOLON);
-  compileBlock();
-  eat(SB_SEMICOLON);
+  eat(compiler, SB_SEMICOLON);
+  compileBlock(compiler);
+  eat(compiler, SB_SEMICOLON);
 
-  exitBlock();
+  exitBlock(compiler->symtab);
 }
 
-ConstantValue* compileUnsignedConstant(void) {
+ConstantValue* compileUnsignedConstant(Compiler* compiler) {
   ConstantValue* constValue;
   Object* obj;
 
-  switch (lookAhead->tokenType) {
+  switch (compiler->lookAhead->tokenType) {
   case TK_NUMBER:
-    eat(TK_NUMBER);
-    constValue = makeIntConstant(currentToken->value);
+    eat(compiler, TK_NUMBER);
+    constValue = makeIntConstant(compiler->currentToken->value);
     break;
   case TK_IDENT:
-    eat(TK_IDENT);
+    eat(compiler, TK_IDENT);
 
-    obj = checkDeclaredConstant(currentToken->string);
+    obj = checkDeclaredConstant(compiler, compiler->currentToken->name);
     constValue = duplicateConstantValue(obj->constAttrs->value);
 
     break;
   case TK_CHAR:
-    eat(TK_CHAR);
-    constValue = makeCharConstant(currentToken->string[0]);
+    eat(compiler, TK_CHAR);
+    constValue = makeCharConstant(compiler->currentToken->string[0]);
     break;
   default:
-    error(ERR_INVALID_CONSTANT, lookAhead->lineNo, lookAhead->colNo);
+    error(compiler, ERR_INVALID_CONSTANT, compiler->lookAhead->lineNo, compiler->lookAhead->colNo);
     break;
   }
   return constValue;
 }
 
-ConstantValue* compileConstant(void) {
+ConstantValue* compileConstant(Compiler* compiler) {
   ConstantValue* constValue;
 
-  switch (lookAhead->tokenType) {
+  switch (compiler->lookAhead->tokenType) {
   case SB_PLUS:
-    eat(SB_PLUS);
-    constValue = compileConstant2();
+    eat(compiler, SB_PLUS);
+    constValue = compileConstant2(compiler);
     break;
   case SB_MINUS:
-    eat(SB_MINUS);
-    constValue = compileConstant2();
+    eat(compiler, SB_MINUS);
+    constValue = compileConstant2(compiler);
     constValue->intValue = - constValue->intValue;
     break;
   case TK_CHAR:
-    eat(TK_CHAR);
-    constValue = makeCharConstant(currentToken->string[0]);
+    eat(compiler, TK_CHAR);
+    constValue = makeCharConstant(compiler->currentToken->string[0]);
     break;
   default:
-    constValue = compileConstant2();
+    constValue = compileConstant2(compiler);
     break;
   }
   return constValue;
 }
 
-ConstantValue* compileConstant2(void) {
+ConstantValue* compileConstant2(Compiler* compiler) {
   ConstantValue* constValue;
   Object* obj;
 
-  switch (lookAhead->tokenType) {
+  switch (compiler->lookAhead->tokenType) {
   case TK_NUMBER:
-    eat(TK_NUMBER);
-    constValue = makeIntConstant(currentToken->value);
+    eat(compiler, TK_NUMBER);
+    constValue = makeIntConstant(compiler->currentToken->value);
     break;
   case TK_IDENT:
-    eat(TK_IDENT);
-    obj = checkDeclaredConstant(currentToken->string);
+    eat(compiler, TK_IDENT);
+    obj = checkDeclaredConstant(compiler, compiler->currentToken->name);
     if (obj->constAttrs->value->type == TP_INT)
       constValue = duplicateConstantValue(obj->constAttrs->value);
     else
-      error(ERR_UNDECLARED_INT_CONSTANT,currentToken->lineNo, currentToken->colNo);
+      error(compiler, ERR_UNDECLARED_INT_CONSTANT,compiler->currentToken->lineNo, compiler->currentToken->colNo);
     break;
   default:
-    error(ERR_INVALID_CONSTANT, lookAhead->lineNo, lookAhead->colNo);
+    error(compiler, ERR_INVALID_CONSTANT, compiler->lookAhead->lineNo, compiler->lookAhead->colNo);
     break;
   }
   return constValue;
 }
 
-Type* compileType(void) {
+Type* compileType(Compiler* compiler) {
   Type* type;
   Type* elementType;
   int arraySize;
   Object* obj;
 
-  switch (lookAhead->tokenType) {
+  switch (compiler->lookAhead->tokenType) {
   case KW_INTEGER: 
-    eat(KW_INTEGER);
+    eat(compiler, KW_INTEGER);
     type =  makeIntType();
     break;
   case KW_CHAR: 
-    eat(KW_CHAR); 
+    eat(compiler, KW_CHAR); 
     type = makeCharType();
     break;
   case KW_ARRAY:
-    eat(KW_ARRAY);
-    eat(SB_LSEL);
-    eat(TK_NUMBER);
+    eat(compiler, KW_ARRAY);
+    eat(compiler, SB_LSEL);
+    eat(compiler, TK_NUMBER);
 
-    arraySize = currentToken->value;
+    arraySize = compiler->currentToken->value;
 
-    eat(SB_RSEL);
-    eat(KW_OF);
-    elementType = compileType();
+    eat(compiler, SB_RSEL);
+    eat(compiler, KW_OF);
+    elementType = compileType(compiler);
     type = makeArrayType(arraySize, elementType);
     break;
   case TK_IDENT:
-    eat(TK_IDENT);
-    obj = checkDeclaredType(currentToken->string);
+    eat(compiler, TK_IDENT);
+    obj = checkDeclaredType(compiler, compiler->currentToken->name);
     type = duplicateType(obj->typeAttrs->actualType);
     break;
   default:
-    error(ERR_INVALID_TYPE, lookAhead->lineNo, lookAhead->colNo);
+    error(compiler, ERR_INVALID_TYPE, compiler->lookAhead->lineNo, compiler->lookAhead->colNo);
     break;
   }
   return type;
 }
 
-Type* compileBasicType(void) {
+Type* compileBasicType(Compiler* compiler) {
   Type* type;
 
-  switch (lookAhead->tokenType) {
+  switch (compiler->lookAhead->tokenType) {
   case KW_INTEGER: 
-    eat(KW_INTEGER); 
+    eat(compiler, KW_INTEGER); 
     type = makeIntType();
     break;
   case KW_CHAR: 
-    eat(KW_CHAR); 
+    eat(compiler, KW_CHAR); 
     type = makeCharType();
     break;
   default:
-    error(ERR_INVALID_BASICTYPE, lookAhead->lineNo, lookAhead->colNo);
+    error(compiler, ERR_INVALID_BASICTYPE, compiler->lookAhead->lineNo, compiler->lookAhead->colNo);
     break;
   }
   return type;
 }
 
-void compileParams(void) {
-  if (lookAhead->tokenType == SB_LPAR) {
-    eat(SB_LPAR);
-    compileParam();
-    while (lookAhead->tokenType == SB_SEMICOLON) {
-      eat(SB_SEMICOLON);
-      compileParam();
+void compileParams(Compiler* compiler) {
+  if (compiler->lookAhead->tokenType == SB_LPAR) {
+    eat(compiler, SB_LPAR);
+    compileParam(compiler);
+    while (compiler->lookAhead->tokenType == SB_SEMICOLON) {
+      eat(compiler, SB_SEMICOLON);
+      compileParam(compiler);
     }
-    eat(SB_RPAR);
+    eat(compiler, SB_RPAR);
   }
 }
 
-void compileParam(void) {
+void compileParam(Compiler* compiler) {
   Object* param;
   Type* type;
   enum ParamKind paramKind;
 
-  switch (lookAhead->tokenType) {
+  switch (compiler->lookAhead->tokenType) {
   case TK_IDENT:
     paramKind = PARAM_VALUE;
     break;
   case KW_VAR:
-    eat(KW_VAR);
+    eat(compiler, KW_VAR);
     paramKind = PARAM_REFERENCE;
     break;
   default:
-    error(ERR_INVALID_PARAMETER, lookAhead->lineNo, lookAhead->colNo);
+    error(compiler, ERR_INVALID_PARAMETER, compiler->lookAhead->lineNo, compiler->lookAhead->colNo);
     break;
   }
 
-  eat(TK_IDENT);
-  checkFreshIdent(currentToken->string);
-  param = createParameterObject(currentToken->string, paramKind, symtab->currentScope->owner);
-  eat(SB_COLON);
-  type = compileBasicType();
+  eat(compiler, TK_IDENT);
+  checkFreshIdent(compiler, compiler->currentToken->name);
+  param = createParameterObject(compiler->currentToken->name, paramKind, compiler->symtab->currentScope->owner);
+  compiler->pending = param;
+  eat(compiler, SB_COLON);
+  type = compileBasicType(compiler);
   param->paramAttrs->type = type;
-  declareObject(param);
+  declareObject(compiler->symtab, param);
+  compiler->pending = NULL;
 }
 
-void compileStatements(void) {
-  compileStatement();
-  while (lookAhead->tokenType == SB_SEMICOLON) {
-    eat(SB_SEMICOLON);
-    compileStatement();
+void compileStatements(Compiler* compiler) {
+  compileStatement(compiler);
+  while (compiler->lookAhead->tokenType == SB_SEMICOLON) {
+    eat(compiler, SB_SEMICOLON);
+    compileStatement(compiler);
   }
 }
 
-void compileStatement(void) {
-  switch (lookAhead->tokenType) {
+void compileStatement(Compiler* compiler) {
+  switch (compiler->lookAhead->tokenType) {
   case TK_IDENT:
-    compileAssignSt();
+    compileAssignSt(compiler);
     break;
   case KW_CALL:
-    compileCallSt();
+    compileCallSt(compiler);
     break;
   case KW_BEGIN:
-    compileGroupSt();
+    compileGroupSt(compiler);
     break;
   case KW_IF:
-    compileIfSt();
+    compileIfSt(compiler);
     break;
   case KW_WHILE:
-    compileWhileSt();
+    compileWhileSt(compiler);
     break;
   case KW_FOR:
-    compileForSt();
+    compileForSt(compiler);
     break;
   case SB_SEMICOLON:
   case KW_END:
   case KW_ELSE:
     break;
   default:
-    error(ERR_INVALID_STATEMENT, lookAhead->lineNo, lookAhead->colNo);
+    error(compiler, ERR_INVALID_STATEMENT, compiler->lookAhead->lineNo, compiler->lookAhead->colNo);
     break;
   }
 }
 
-Type* compileLValue(void) {
+Type* compileLValue(Compiler* compiler) {
   Object* var;
   Type* varType = NULL;
 
-  eat(TK_IDENT);
-  var = checkDeclaredLValueIdent(currentToken->string);
+  eat(compiler, TK_IDENT);
+  var = checkDeclaredLValueIdent(compiler, compiler->currentToken->name);
 
   switch (var->kind) {
   case OBJ_VARIABLE:
     if (var->varAttrs->type->typeClass == TP_ARRAY) {
-       varType = compileIndexes(var->varAttrs->type);
+       varType = compileIndexes(compiler, var->varAttrs->type);
     } else {
        varType = var->varAttrs->type;
     }
@@ -424,111 +428,111 @@ Type* compileLValue(void) {
     varType = var->funcAttrs->returnType;
     break;
   default: 
-    error(ERR_INVALID_LVALUE, currentToken->lineNo, currentToken->colNo);
+    error(compiler, ERR_INVALID_LVALUE, compiler->currentToken->lineNo, compiler->currentToken->colNo);
   }
   
   return varType;
 }
 
-void compileAssignSt(void) {
-  Type* lvalueType = compileLValue();
+void compileAssignSt(Compiler* compiler) {
+  Type* lvalueType = compileLValue(compiler);
   Type* expType;
 
-  eat(SB_ASSIGN);
-  expType = compileExpression();
+  eat(compiler, SB_ASSIGN);
+  expType = compileExpression(compiler);
 
-  checkTypeEquality(lvalueType, expType);
+  checkTypeEquality(compiler, lvalueType, expType);
 }
 
-void compileCallSt(void) {
+void compileCallSt(Compiler* compiler) {
   Object* proc;
 
-  eat(KW_CALL);
-  eat(TK_IDENT);
+  eat(compiler, KW_CALL);
+  eat(compiler, TK_IDENT);
 
-  proc = checkDeclaredProcedure(currentToken->string);
+  proc = checkDeclaredProcedure(compiler, compiler->currentToken->name);
 
-  compileArguments(proc->procAttrs->paramList);
+  compileArguments(compiler, proc->procAttrs->paramList);
 }
 
-void compileGroupSt(void) {
-  eat(KW_BEGIN);
-  compileStatements();
-  eat(KW_END);
+void compileGroupSt(Compiler* compiler) {
+  eat(compiler, KW_BEGIN);
+  compileStatements(compiler);
+  eat(compiler, KW_END);
 }
 
-void compileIfSt(void) {
-  eat(KW_IF);
-  compileCondition();
-  eat(KW_THEN);
-  compileStatement();
-  if (lookAhead->tokenType == KW_ELSE) 
-    compileElseSt();
+void compileIfSt(Compiler* compiler) {
+  eat(compiler, KW_IF);
+  compileCondition(compiler);
+  eat(compiler, KW_THEN);
+  compileStatement(compiler);
+  if (compiler->lookAhead->tokenType == KW_ELSE) 
+    compileElseSt(compiler);
 }
 
-void compileElseSt(void) {
-  eat(KW_ELSE);
-  compileStatement();
+void compileElseSt(Compiler* compiler) {
+  eat(compiler, KW_ELSE);
+  compileStatement(compiler);
 }
 
-void compileWhileSt(void) {
-  eat(KW_WHILE);
-  compileCondition();
-  eat(KW_DO);
-  compileStatement();
+void compileWhileSt(Compiler* compiler) {
+  eat(compiler, KW_WHILE);
+  compileCondition(compiler);
+  eat(compiler, KW_DO);
+  compileStatement(compiler);
 }
 
-void compileForSt(void) {
+void compileForSt(Compiler* compiler) {
   Object* var; 
   Type *type;
 
-  eat(KW_FOR);
-  eat(TK_IDENT);
+  eat(compiler, KW_FOR);
+  eat(compiler, TK_IDENT);
 
-  var = checkDeclaredVariable(currentToken->string);
-  checkBasicType(var->varAttrs->type);
+  var = checkDeclaredVariable(compiler, compiler->currentToken->name);
+  checkBasicType(compiler, var->varAttrs->type);
 
-  eat(SB_ASSIGN);
-  type = compileExpression();
-  checkTypeEquality(var->varAttrs->type, type);
+  eat(compiler, SB_ASSIGN);
+  type = compileExpression(compiler);
+  checkTypeEquality(compiler, var->varAttrs->type, type);
 
-  eat(KW_TO);
-  type = compileExpression();
-  checkTypeEquality(var->varAttrs->type, type);
+  eat(compiler, KW_TO);
+  type = compileExpression(compiler);
+  checkTypeEquality(compiler, var->varAttrs->type, type);
 
-  eat(KW_DO);
-  compileStatement();
+  eat(compiler, KW_DO);
+  compileStatement(compiler);
 }
 
-void compileArgument(Object* param) {
-  Type* type = compileExpression();
-  checkTypeEquality(type, param->paramAttrs->type);
+void compileArgument(Compiler* compiler, Object* param) {
+  Type* type = compileExpression(compiler);
+  checkTypeEquality(compiler, type, param->paramAttrs->type);
 }
 
-void compileArguments(ObjectNode* paramList) {
+void compileArguments(Compiler* compiler, ObjectNode* paramList) {
   ObjectNode* node = paramList;
 
-  switch (lookAhead->tokenType) {
+  switch (compiler->lookAhead->tokenType) {
   case SB_LPAR:
-    eat(SB_LPAR);
+    eat(compiler, SB_LPAR);
     if (node == NULL) 
-      error(ERR_PARAMETERS_ARGUMENTS_INCONSISTENCY, currentToken->lineNo, currentToken->colNo);
+      error(compiler, ERR_PARAMETERS_ARGUMENTS_INCONSISTENCY, compiler->currentToken->lineNo, compiler->currentToken->colNo);
     
-    compileArgument(node->object);
+    compileArgument(compiler, node->object);
     node = node->next;
 
-    while (lookAhead->tokenType == SB_COMMA) {
-      eat(SB_COMMA);
+    while (compiler->lookAhead->tokenType == SB_COMMA) {
+      eat(compiler, SB_COMMA);
       if (node == NULL) 
-         error(ERR_PARAMETERS_ARGUMENTS_INCONSISTENCY, currentToken->lineNo, currentToken->colNo);
+         error(compiler, ERR_PARAMETERS_ARGUMENTS_INCONSISTENCY, compiler->currentToken->lineNo, compiler->currentToken->colNo);
       
-      compileArgument(node->object);
+      compileArgument(compiler, node->object);
       node = node->next;
     }
     
-    eat(SB_RPAR);
+    eat(compiler, SB_RPAR);
     if (node != NULL) 
-      error(ERR_PARAMETERS_ARGUMENTS_INCONSISTENCY, currentToken->lineNo, currentToken->colNo);
+      error(compiler, ERR_PARAMETERS_ARGUMENTS_INCONSISTENCY, compiler->currentToken->lineNo, compiler->currentToken->colNo);
     break;
     
   case SB_TIMES:
@@ -551,92 +555,92 @@ void compileArguments(ObjectNode* paramList) {
   case KW_ELSE:
   case KW_THEN:
     if (node != NULL)
-      error(ERR_PARAMETERS_ARGUMENTS_INCONSISTENCY, currentToken->lineNo, currentToken->colNo);
+      error(compiler, ERR_PARAMETERS_ARGUMENTS_INCONSISTENCY, compiler->currentToken->lineNo, compiler->currentToken->colNo);
     break;
   default:
-    error(ERR_INVALID_ARGUMENTS, lookAhead->lineNo, lookAhead->colNo);
+    error(compiler, ERR_INVALID_ARGUMENTS, compiler->lookAhead->lineNo, compiler->lookAhead->colNo);
   }
 }
 
-void compileCondition(void) {
+void compileCondition(Compiler* compiler) {
   Type* type1;
   Type* type2;
 
-  type1 = compileExpression();
-  checkBasicType(type1);
+  type1 = compileExpression(compiler);
+  checkBasicType(compiler, type1);
 
-  switch (lookAhead->tokenType) {
+  switch (compiler->lookAhead->tokenType) {
   case SB_EQ:
-    eat(SB_EQ);
+    eat(compiler, SB_EQ);
     break;
   case SB_NEQ:
-    eat(SB_NEQ);
+    eat(compiler, SB_NEQ);
     break;
   case SB_LE:
-    eat(SB_LE);
+    eat(compiler, SB_LE);
     break;
   case SB_LT:
-    eat(SB_LT);
+    eat(compiler, SB_LT);
     break;
   case SB_GE:
-    eat(SB_GE);
+    eat(compiler, SB_GE);
     break;
   case SB_GT:
-    eat(SB_GT);
+    eat(compiler, SB_GT);
     break;
   default:
-    error(ERR_INVALID_COMPARATOR, lookAhead->lineNo, lookAhead->colNo);
+    error(compiler, ERR_INVALID_COMPARATOR, compiler->lookAhead->lineNo, compiler->lookAhead->colNo);
   }
 
-  type2 = compileExpression();
-  checkTypeEquality(type1, type2);
+  type2 = compileExpression(compiler);
+  checkTypeEquality(compiler, type1, type2);
 }
 
-Type* compileExpression(void) {
+Type* compileExpression(Compiler* compiler) {
   Type* type;
   
-  switch (lookAhead->tokenType) {
+  switch (compiler->lookAhead->tokenType) {
   case SB_PLUS:
-    eat(SB_PLUS);
-    type = compileExpression2();
-    checkIntType(type);
+    eat(compiler, SB_PLUS);
+    type = compileExpression2(compiler);
+    checkIntType(compiler, type);
     break;
   case SB_MINUS:
-    eat(SB_MINUS);
-    type = compileExpression2();
-    checkIntType(type);
+    eat(compiler, SB_MINUS);
+    type = compileExpression2(compiler);
+    checkIntType(compiler, type);
     break;
   default:
-    type = compileExpression2();
+    type = compileExpression2(compiler);
   }
   return type;
 }
 
-Type* compileExpression2(void) {
+Type* compileExpression2(Compiler* compiler) {
   Type* type;
 
-  type = compileTerm();
-  compileExpression3();
+  type = compileTerm(compiler);
+  compileExpression3(compiler);
 
   return type;
 }
 
 
-void compileExpression3(void) {
+void compileExpression3(Compiler* compiler) {
   Type* type;
 
-  switch (lookAhead->tokenType) {
+  switch (compiler->lookAhead->tokenType) {
   case SB_PLUS:
-    eat(SB_PLUS);
-    type = compileTerm();
-    checkIntType(type);
-    compileExpression3();
+    eat(compiler, SB_PLUS);
+    type = compileTerm(compiler);
+    checkIntType(compiler, type);
+    compileExpression3(compiler);
     break;
   case SB_MINUS:
-    eat(SB_MINUS);
-    type = compileTerm();
-    checkIntType(type);
-    compileExpression3();
+    eat(compiler, SB_MINUS);
+    type = compileTerm(compiler);
+    checkIntType(compiler, type);
+    compileExpression3(compiler);
     break;
   case KW_TO:
   case KW_DO:
@@ -655,34 +659,34 @@ void compileExpression3(void) {
   case KW_THEN:
     break;
   default:
-    error(ERR_INVALID_EXPRESSION, lookAhead->lineNo, lookAhead->colNo);
+    error(compiler, ERR_INVALID_EXPRESSION, compiler->lookAhead->lineNo, compiler->lookAhead->colNo);
   }
 }
 
-Type* compileTerm(void) {
+Type* compileTerm(Compiler* compiler) {
   Type* type;
 
-  type = compileFactor();
-  compileTerm2();
+  type = compileFactor(compiler);
+  compileTerm2(compiler);
 
   return type;
 }
 
-void compileTerm2(void) {
+void compileTerm2(Compiler* compiler) {
   Type* type;
 
-  switch (lookAhead->tokenType) {
+  switch (compiler->lookAhead->tokenType) {
   case SB_TIMES:
-    eat(SB_TIMES);
-    type = compileFactor();
-    checkIntType(type);
-    compileTerm2();
+    eat(compiler, SB_TIMES);
+    type = compileFactor(compiler);
+    checkIntType(compiler, type);
+    compileTerm2(compiler);
     break;
   case SB_SLASH:
-    eat(SB_SLASH);
-    type = compileFactor();
-    checkIntType(type);
-    compileTerm2();
+    eat(compiler, SB_SLASH);
+    type = compileFactor(compiler);
+    checkIntType(compiler, type);
+    compileTerm2(compiler);
     break;
   case SB_PLUS:
   case SB_MINUS:
@@ -703,37 +707,37 @@ void compileTerm2(void) {
   case KW_THEN:
     break;
   default:
-    error(ERR_INVALID_TERM, lookAhead->lineNo, lookAhead->colNo);
+    error(compiler, ERR_INVALID_TERM, compiler->lookAhead->lineNo, compiler->lookAhead->colNo);
   }
 }
 
-Type* compileFactor(void) {
+Type* compileFactor(Compiler* compiler) {
   Object* obj;
   Type* type = NULL;
 
-  switch (lookAhead->tokenType) {
+  switch (compiler->lookAhead->tokenType) {
   case TK_NUMBER:
-    eat(TK_NUMBER);
-    type = intType;
+    eat(compiler, TK_NUMBER);
+    type = compiler->symtab->intType;
     break;
   case TK_CHAR:
-    eat(TK_CHAR);
-    type = charType;
+    eat(compiler, TK_CHAR);
+    type = compiler->symtab->charType;
     break;
   case TK_IDENT:
-    eat(TK_IDENT);
-    obj = checkDeclaredIdent(currentToken->string);
+    eat(compiler, TK_IDENT);
+    obj = checkDeclaredIdent(compiler, compiler->currentToken->name);
 
     switch (obj->kind) {
     case OBJ_CONSTANT:
       if (obj->constAttrs->value->type == TP_INT)
-          type = intType;
+          type = compiler->symtab->intType;
       else 
-          type = charType;
+          type = compiler->symtab->charType;
       break;
     case OBJ_VARIABLE:
       if (obj->varAttrs->type->typeClass == TP_ARRAY)
-          type = compileIndexes(obj->varAttrs->type);
+          type = compileIndexes(compiler, obj->varAttrs->type);
       else 
           type = obj->varAttrs->type;
       break;
@@ -741,60 +745,88 @@ Type* compileFactor(void) {
       type = obj->paramAttrs->type;
       break;
     case OBJ_FUNCTION:
-      compileArguments(obj->funcAttrs->paramList);
+      compileArguments(compiler, obj->funcAttrs->paramList);
       type = obj->funcAttrs->returnType;
       break;
     default: 
-      error(ERR_INVALID_FACTOR,currentToken->lineNo, currentToken->colNo);
+      error(compiler, ERR_INVALID_FACTOR,compiler->currentToken->lineNo, compiler->currentToken->colNo);
       break;
     }
     break;
   case SB_LPAR:
-    eat(SB_LPAR);
-    type = compileExpression();
-    eat(SB_RPAR);
+    eat(compiler, SB_LPAR);
+    type = compileExpression(compiler);
+    eat(compiler, SB_RPAR);
     break;
   default:
-    error(ERR_INVALID_FACTOR, lookAhead->lineNo, lookAhead->colNo);
+    error(compiler, ERR_INVALID_FACTOR, compiler->lookAhead->lineNo, compiler->lookAhead->colNo);
   }
   
   return type;
 }
 
-Type* compileIndexes(Type* arrayType) {
+Type* compileIndexes(Compiler* compiler, Type* arrayType) {
   Type* type = arrayType;
   
-  while (lookAhead->tokenType == SB_LSEL) {
-    eat(SB_LSEL);
-    checkArrayType(type); 
+  while (compiler->lookAhead->tokenType == SB_LSEL) {
+    eat(compiler, SB_LSEL);
+    checkArrayType(compiler, type); 
     
-    Type* idxType = compileExpression();
-    checkIntType(idxType); 
+    Type* idxType = compileExpression(compiler);
+    checkIntType(compiler, idxType); 
 
-    eat(SB_RSEL);
+    eat(compiler, SB_RSEL);
     
     type = type->elementType; 
   }
   return type;
 }
 
-int compile(char *fileName) {
-  if (openInputStream(fileName) == IO_ERROR)
+// Runs the parser; error() lands back here instead of terminating the process
+static int parseProgram(Compiler* compiler) {
+  if (setjmp(compiler->errorJump) != 0)
+    return 0;
+
+  compiler->lookAhead = getValidToken(compiler, compiler->lookAhead);
+  compileProgram(compiler);
+  return 1;
+}
+
+int compileFile(char *fileName, FILE *output, CompileResult *result) {
+  Compiler compiler;
+
+  initScanner();
+  if (openInputStream(&compiler.reader, fileName) == IO_ERROR)
     return IO_ERROR;
 
-  currentToken = NULL;
-  lookAhead = getValidToken();
+  memset(compiler.tokens, 0, sizeof(compiler.tokens));
+  compiler.currentToken = &compiler.tokens[0];
+  compiler.lookAhead = &compiler.tokens[1];
+  compiler.pending = NULL;
+  compiler.output = output;
+  compiler.result.failed = 0;
+  compiler.result.lineNo = compiler.result.colNo = 0;
+  compiler.result.message[0] = '\0';
 
-  initSymTab();
+  initNameTable(&compiler.names);
+  compiler.symtab = initSymTab(&compiler.names);
 
-  compileProgram();
+  if (parseProgram(&compiler))
+    printObject(output, compiler.symtab->program,0);
+  else if (compiler.pending != NULL)
+    freeObject(compiler.pending);
 
-  printObject(symtab->program,0);
+  cleanSymTab(compiler.symtab);
+  freeNameTable(&compiler.names);
 
-  cleanSymTab();
+  compiler.result.lines = compiler.reader.lineNo;
+  closeInputStream(&compiler.reader);
 
-  free(currentToken);
-  free(lookAhead);
-  closeInputStream();
+  if (result != NULL)
+    *result = compiler.result;
   return IO_SUCCESS;
-}
\ No newline at end of file
+}
+
+int compile(char *fileName) {
+  return compileFile(fileName, stdout, NULL);
+}
@@ -5,55 +5,56 @@
  */
 #ifndef __PARSER_H__
 #define __PARSER_H__
-#include "token.h"
-#include "symtab.h"
+#include "compiler.h"
 
-void scan(void);
-void eat(TokenType tokenType);
+void scan(Compiler* compiler);
+void eat(Compiler* compiler, TokenType tokenType);
 
-void compileProgram(void);
-void compileBlock(void);
-void compileBlock2(void);
-void compileBlock3(void);
-void compileBlock4(void);
-void compileBlock5(void);
-void compileConstDecls(void);
-void compileConstDecl(void);
-void compileTypeDecls(void);
-void compileTypeDecl(void);
-void compileVarDecls(void);
-void compileVarDecl(void);
-void compileSubDecls(void);
-void compileFuncDecl(void);
-void compileProcDecl(void);
-ConstantValue* compileUnsignedConstant(void);
-ConstantValue* compileConstant(void);
-ConstantValue* compileConstant2(void);
-Type* compileType(void);
-Type* compileBasicType(void);
-void compileParams(void);
-void compileParam(void);
-void compileStatements(void);
-void compileStatement(void);
-Type* compileLValue(void);
-void compileAssignSt(void);
-void compileCallSt(void);
-void compileGroupSt(void);
-void compileIfSt(void);
-void compileElseSt(void);
-void compileWhileSt(void);
-void compileForSt(void);
-void compileArgument(Object* param);
-void compileArguments(ObjectNode* paramList);
-void compileCondition(void);
-Type* compileExpression(void);
-Type* compileExpression2(void);
-void compileExpression3(void);
-Type* compileTerm(void);
-void compileTerm2(void);
-Type* compileFactor(void);
-Type* compileIndexes(Type* arrayType);
+void compileProgram(Compiler* compiler);
+void compileBlock(Compiler* compiler);
+void compileBlock2(Compiler* compiler);
+void compileBlock3(Compiler* compiler);
+void compileBlock4(Compiler* compiler);
+void compileBlock5(Compiler* compiler);
+void compileConstDecls(Compiler* compiler);
+void compileConstDecl(Compiler* compiler);
+void compileTypeDecls(Compiler* compiler);
+void compileTypeDecl(Compiler* compiler);
+void compileVarDecls(Compiler* compiler);
+void compileVarDecl(Compiler* compiler);
+void compileSubDecls(Compiler* compiler);
+void compileFuncDecl(Compiler* compiler);
+void compileProcDecl(Compiler* compiler);
+ConstantValue* compileUnsignedConstant(Compiler* compiler);
+ConstantValue* compileConstant(Compiler* compiler);
+ConstantValue* compileConstant2(Compiler* compiler);
+Type* compileType(Compiler* compiler);
+Type* compileBasicType(Compiler* compiler);
+void compileParams(Compiler* compiler);
+void compileParam(Compiler* compiler);
+void compileStatements(Compiler* compiler);
+void compileStatement(Compiler* compiler);
+Type* compileLValue(Compiler* compiler);
+void compileAssignSt(Compiler* compiler);
+void compileCallSt(Compiler* compiler);
+void compileGroupSt(Compiler* compiler);
+void compileIfSt(Compiler* compiler);
+void compileElseSt(Compiler* compiler);
+void compileWhileSt(Compiler* compiler);
+void compileForSt(Compiler* compiler);
+void compileArgument(Compiler* compiler, Object* param);
+void compileArguments(Compiler* compiler, ObjectNode* paramList);
+void compileCondition(Compiler* compiler);
+Type* compileExpression(Compiler* compiler);
+Type* compileExpression2(Compiler* compiler);
+void compileExpression3(Compiler* compiler);
+Type* compileTerm(Compiler* compiler);
+void compileTerm2(Compiler* compiler);
+Type* compileFactor(Compiler* compiler);
+Type* compileIndexes(Compiler* compiler, Type* arrayType);
 
+// Compile one file, writing the symbol table or the first diagnostic to output
+int compileFile(char *fileName, FILE *output, CompileResult *result);
 int compile(char *fileName);
 
 #endif
@@ -5,33 +5,96 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "reader.h"
 
-FILE *inputStream;
-int lineNo, colNo;
-int currentChar;
+// Load the next block; the buffer is empty whenever this is called
+static int loadBuffer(Reader *reader) {
+  size_t n = 0;
 
-int readChar(void) {
-  currentChar = getc(inputStream);
-  colNo ++;
-  if (currentChar == '\n') {
-    lineNo ++;
-    colNo = 0;
+  if (reader->inputStream != NULL)
+    n = fread(reader->buffer, 1, READER_BUFFER_SIZE, reader->inputStream);
+  reader->pos = reader->buffer;
+  reader->end = reader->buffer + n;
+  return n > 0;
+}
+
+// Slow path of readChar: consume the first character of the next block
+int fillBuffer(Reader *reader) {
+  if (!loadBuffer(reader))
+    return EOF;
+  return *reader->pos++;
+}
+
+// Slow path of peekChar: the next block stays unread
+int refillBuffer(Reader *reader) {
+  if (!loadBuffer(reader))
+    return EOF;
+  return *reader->pos;
+}
+
+// Number of '\n' in [p, end), 16 bytes at a time where SSE2 is available
+static int countNewlines(const unsigned char *p, const unsigned char *end) {
+  int n = 0;
+#ifdef __SSE2__
+  const __m128i newline = _mm_set1_epi8('\n');
+
+  for (; end - p >= 16; p += 16) {
+    __m128i block = _mm_loadu_si128((const __m128i*) p);
+    n += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline)));
   }
-  return currentChar;
+#endif
+  for (; p < end; p++)
+    n += (*p == '\n');
+  return n;
 }
 
-int openInputStream(char *fileName) {
-  inputStream = fopen(fileName, "rt");
-  if (inputStream == NULL)
+void advanceReader(Reader *reader, const unsigned char *to) {
+  const unsigned char *from = reader->pos;
+  int newlines;
+
+  if (to <= from)
+    return;
+
+  newlines = countNewlines(from, to);
+  if (newlines > 0) {
+    const unsigned char *last = to - 1;
+    while (*last != '\n')
+      last--;
+    reader->lineNo += newlines;
+    reader->colNo = to - 1 - last;
+  } else reader->colNo += to - from;
+
+  reader->currentChar = to[-1];
+  reader->pos = to;
+}
+
+int openInputStream(Reader *reader, char *fileName) {
+  reader->inputStream = fopen(fileName, "rt");
+  if (reader->inputStream == NULL)
     return IO_ERROR;
-  lineNo = 1;
-  colNo = 0;
-  readChar();
+  reader->buffer = (unsigned char*) malloc(READER_BUFFER_SIZE);
+  if (reader->buffer == NULL) {
+    fclose(reader->inputStream);
+    reader->inputStream = NULL;
+    return IO_ERROR;
+  }
+  // The reader does its own buffering, stdio would only copy the block twice
+  setvbuf(reader->inputStream, NULL, _IONBF, 0);
+  reader->pos = reader->end = reader->buffer;
+  reader->lineNo = 1;
+  reader->colNo = 0;
+  readChar(reader);
   return IO_SUCCESS;
 }
 
-void closeInputStream() {
-  fclose(inputStream);
+void closeInputStream(Reader *reader) {
+  fclose(reader->inputStream);
+  reader->inputStream = NULL;
+  free(reader->buffer);
+  reader->buffer = NULL;
+  reader->pos = reader->end = NULL;
 }
-
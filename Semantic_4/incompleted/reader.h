@@ -7,11 +7,48 @@
 #ifndef __READER_H__
 #define __READER_H__
 
+#include <stdio.h>
+
 #define IO_ERROR 0
 #define IO_SUCCESS 1
 
-int readChar(void);
-int openInputStream(char *fileName);
-void closeInputStream(void);
+#define READER_BUFFER_SIZE 65536
+
+// Input state of one source file; each compilation owns its reader
+typedef struct {
+  FILE *inputStream;
+  int lineNo, colNo;
+  int currentChar;
+  // Unread part of the input buffer: [pos, end)
+  const unsigned char *pos;
+  const unsigned char *end;
+  unsigned char *buffer;
+} Reader;
+
+int fillBuffer(Reader *reader);
+int refillBuffer(Reader *reader);
+
+// Advance to the next character; only an empty buffer costs a call
+static inline int readChar(Reader *reader) {
+  reader->currentChar = (reader->pos < reader->end) ? *reader->pos++ : fillBuffer(reader);
+  reader->colNo ++;
+  if (reader->currentChar == '\n') {
+    reader->lineNo ++;
+    reader->colNo = 0;
+  }
+  return reader->currentChar;
+}
+
+// The character after currentChar, without consuming it
+static inline int peekChar(Reader *reader) {
+  return (reader->pos < reader->end) ? *reader->pos : refillBuffer(reader);
+}
+
+// Consume the buffered bytes [pos, to) at once, with the same effect on currentChar,
+// lineNo and colNo as that many readChar() calls; to must not be past end
+void advanceReader(Reader *reader, const unsigned char *to);
+
+int openInputStream(Reader *reader, char *fileName);
+void closeInputStream(Reader *reader);
 
 #endif
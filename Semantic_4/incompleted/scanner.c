@@ -7,6 +7,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <pthread.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "reader.h"
 #include "charcode.h"
@@ -15,73 +19,133 @@
 #include "scanner.h"
 
 
-extern int lineNo;
-extern int colNo;
-extern int currentChar;
-
 extern CharCode charCodes[];
 
 /***************************************************************/
 
-void skipBlank() {
-  while ((currentChar != EOF) && (charCodes[currentChar] == CHAR_SPACE))
-    readChar();
+// First byte in [p, end) that is not blank. The blanks are the CHAR_SPACE
+// entries of charCodes[]: ' ' and '\t'..'\r'.
+static const unsigned char *findNonBlank(const unsigned char *p, const unsigned char *end) {
+#ifdef __SSE2__
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i tab = _mm_set1_epi8('\t');
+  const __m128i four = _mm_set1_epi8(4);
+
+  for (; end - p >= 16; p += 16) {
+    __m128i block = _mm_loadu_si128((const __m128i*) p);
+    __m128i control = _mm_sub_epi8(block, tab);
+    // control <= 4 unsigned: '\t', '\n', '\v', '\f', '\r'
+    __m128i blank = _mm_or_si128(_mm_cmpeq_epi8(block, space),
+                                 _mm_cmpeq_epi8(_mm_min_epu8(control, four), control));
+    int mask = _mm_movemask_epi8(blank) ^ 0xFFFF;
+    if (mask != 0)
+      return p + __builtin_ctz(mask);
+  }
+#endif
+  while ((p < end) && (charCodes[*p] == CHAR_SPACE))
+    p++;
+  return p;
 }
 
-void skipComment() {
-  int state = 0;
-  while ((currentChar != EOF) && (state < 2)) {
-    switch (charCodes[currentChar]) {
-    case CHAR_TIMES:
-      state = 1;
-      break;
-    case CHAR_RPAR:
-      if (state == 1) state = 2;
-      else state = 0;
-      break;
-    default:
-      state = 0;
+// The '*' of the first "*)" lying entirely in [p, end), or NULL
+static const unsigned char *findCommentEnd(const unsigned char *p, const unsigned char *end) {
+#ifdef __SSE2__
+  const __m128i star = _mm_set1_epi8('*');
+  const __m128i rpar = _mm_set1_epi8(')');
+
+  for (; end - p >= 17; p += 16) {
+    __m128i first = _mm_loadu_si128((const __m128i*) p);
+    __m128i second = _mm_loadu_si128((const __m128i*) (p + 1));
+    int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, star),
+                                               _mm_cmpeq_epi8(second, rpar)));
+    if (mask != 0)
+      return p + __builtin_ctz(mask);
+  }
+#endif
+  for (; end - p >= 2; p++)
+    if ((p[0] == '*') && (p[1] == ')'))
+      return p;
+  return NULL;
+}
+
+static void skipBlank(Reader *reader) {
+  while ((reader->currentChar != EOF) && (charCodes[reader->currentChar] == CHAR_SPACE)) {
+    // A single blank between tokens is the common case, only runs go in bulk
+    if ((reader->pos < reader->end) && (charCodes[*reader->pos] == CHAR_SPACE))
+      advanceReader(reader, findNonBlank(reader->pos + 1, reader->end));
+    readChar(reader);
+  }
+}
+
+static void skipComment(Compiler* compiler) {
+  Reader *reader = &compiler->reader;
+  const unsigned char *star;
+
+  while (reader->currentChar != EOF) {
+    // Covers a "*)" split between currentChar and the rest of the input
+    if ((reader->currentChar == '*') && (peekChar(reader) == ')')) {
+      readChar(reader);
+      readChar(reader);
+      return;
+    }
+
+    star = findCommentEnd(reader->pos, reader->end);
+    if (star != NULL) {
+      advanceReader(reader, star + 2);
+      readChar(reader);
+      return;
     }
-    readChar();
+
+    if (reader->pos < reader->end)
+      advanceReader(reader, reader->end);
+    else readChar(reader);
   }
-  if (state != 2) 
-    error(ERR_END_OF_COMMENT, lineNo, colNo);
+  error(compiler, ERR_END_OF_COMMENT, reader->lineNo, reader->colNo);
 }
 
-Token* readIdentKeyword(void) {
-  Token *token = makeToken(TK_NONE, lineNo, colNo);
+static Token* readIdentKeyword(Compiler* compiler, Token *token) {
+  Reader *reader = &compiler->reader;
+  makeToken(token, TK_NONE, reader->lineNo, reader->colNo);
   int count = 1;
 
-  token->string[0] = toupper((char)currentChar);
-  readChar();
+  token->string[0] = toupper((char)reader->currentChar);
+  readChar(reader);
 
-  while ((currentChar != EOF) && 
-	 ((charCodes[currentChar] == CHAR_LETTER) || (charCodes[currentChar] == CHAR_DIGIT))) {
-    if (count <= MAX_IDENT_LEN) token->string[count++] = toupper((char)currentChar);
-    readChar();
+  while ((reader->currentChar != EOF) && 
+	 ((charCodes[reader->currentChar] == CHAR_LETTER) || (charCodes[reader->currentChar] == CHAR_DIGIT))) {
+    if (count <= MAX_IDENT_LEN) token->string[count++] = toupper((char)reader->currentChar);
+    readChar(reader);
   }
 
   if (count > MAX_IDENT_LEN) {
-    error(ERR_IDENT_TOO_LONG, token->lineNo, token->colNo);
+    error(compiler, ERR_IDENT_TOO_LONG, token->lineNo, token->colNo);
     return token;
   }
 
   token->string[count] = '\0';
-  token->tokenType = checkKeyword(token->string);
+  token->tokenType = checkKeyword(token->string, count);
 
-  if (token->tokenType == TK_NONE)
+  if (token->tokenType == TK_NONE) {
     token->tokenType = TK_IDENT;
+    token->name = internName(&compiler->names, token->string, count);
+  }
 
   return token;
 }
 
-Token* readNumber(void) {
-  Token *token = makeToken(TK_NUMBER, lineNo, colNo);
+static Token* readNumber(Compiler* compiler, Token *token) {
+  Reader *reader = &compiler->reader;
+  makeToken(token, TK_NUMBER, reader->lineNo, reader->colNo);
   int count = 0;
 
-  while ((currentChar != EOF) && (charCodes[currentChar] == CHAR_DIGIT)) {
-    token->string[count++] = (char)currentChar;
-    readChar();
+  while ((reader->currentChar != EOF) && (charCodes[reader->currentChar] == CHAR_DIGIT)) {
+    if (count <= MAX_IDENT_LEN) token->string[count++] = (char)reader->currentChar;
+    readChar(reader);
+  }
+
+  if (count > MAX_IDENT_LEN) {
+    error(compiler, ERR_NUMBER_TOO_LONG, token->lineNo, token->colNo);
+    return token;
   }
 
   token->string[count] = '\0';
@@ -89,157 +153,178 @@ Token* readNumber(void) {
   return token;
 }
 
-Token* readConstChar(void) {
-  Token *token = makeToken(TK_CHAR, lineNo, colNo);
+static Token* readConstChar(Compiler* compiler, Token *token) {
+  Reader *reader = &compiler->reader;
+  makeToken(token, TK_CHAR, reader->lineNo, reader->colNo);
 
-  readChar();
-  if (currentChar == EOF) {
+  readChar(reader);
+  if (reader->currentChar == EOF) {
     token->tokenType = TK_NONE;
-    error(ERR_INVALID_CONSTANT_CHAR, token->lineNo, token->colNo);
+    error(compiler, ERR_INVALID_CONSTANT_CHAR, token->lineNo, token->colNo);
     return token;
   }
     
-  token->string[0] = currentChar;
+  token->string[0] = reader->currentChar;
   token->string[1] = '\0';
 
-  readChar();
-  if (currentChar == EOF) {
+  readChar(reader);
+  if (reader->currentChar == EOF) {
     token->tokenType = TK_NONE;
-    error(ERR_INVALID_CONSTANT_CHAR, token->lineNo, token->colNo);
+    error(compiler, ERR_INVALID_CONSTANT_CHAR, token->lineNo, token->colNo);
     return token;
   }
 
-  if (charCodes[currentChar] == CHAR_SINGLEQUOTE) {
-    readChar();
+  if (charCodes[reader->currentChar] == CHAR_SINGLEQUOTE) {
+    readChar(reader);
     return token;
   } else {
     token->tokenType = TK_NONE;
-    error(ERR_INVALID_CONSTANT_CHAR, token->lineNo, token->colNo);
+    error(compiler, ERR_INVALID_CONSTANT_CHAR, token->lineNo, token->colNo);
     return token;
   }
 }
 
-Token* getToken(void) {
-  Token *token;
-  int ln, cn;
+/******************* DFA over character classes ******************************/
+
+enum ScannerState {
+  ST_START,
+  ST_LT,              // after '<'
+  ST_GT,              // after '>'
+  ST_EXCLAIMATION,    // after '!'
+  ST_PERIOD,          // after '.'
+  ST_COLON,           // after ':'
+  ST_LPAR,            // after '('
+  SCANNER_STATES
+};
+
+enum ScannerAction {
+  ACT_ERROR,          // invalid symbol at the token start
+  ACT_GOTO,           // consume, go to state value
+  ACT_ACCEPT,         // consume, token value ends here
+  ACT_RETURN,         // token value ended before this character
+  ACT_SKIP,           // blanks between tokens
+  ACT_COMMENT,        // '*' after '(': skip the comment, start over
+  ACT_IDENT,
+  ACT_NUMBER,
+  ACT_CHAR
+};
+
+typedef struct {
+  unsigned char action;
+  unsigned char value;
+} Transition;
+
+static Transition scannerTable[SCANNER_STATES][CHAR_CLASSES];
+// charCodes[] shifted by one so that EOF (-1) has a class too
+static unsigned char charClasses[257];
+static pthread_once_t scannerOnce = PTHREAD_ONCE_INIT;
+
+static void setTransition(int state, CharCode charClass, int action, int value) {
+  scannerTable[state][charClass].action = action;
+  scannerTable[state][charClass].value = value;
+}
 
-  if (currentChar == EOF) 
-    return makeToken(TK_EOF, lineNo, colNo);
+// Two-character symbols: first char leads to state, second char completes token, else shortToken
+static void addPair(CharCode first, int state, CharCode second, TokenType token, TokenType shortToken) {
+  int c;
 
-  switch (charCodes[currentChar]) {
-  case CHAR_SPACE: skipBlank(); return getToken();
-  case CHAR_LETTER: return readIdentKeyword();
-  case CHAR_DIGIT: return readNumber();
-  case CHAR_PLUS: 
-    token = makeToken(SB_PLUS, lineNo, colNo);
-    readChar(); 
-    return token;
-  case CHAR_MINUS:
-    token = makeToken(SB_MINUS, lineNo, colNo);
-    readChar(); 
-    return token;
-  case CHAR_TIMES:
-    token = makeToken(SB_TIMES, lineNo, colNo);
-    readChar(); 
-    return token;
-  case CHAR_SLASH:
-    token = makeToken(SB_SLASH, lineNo, colNo);
-    readChar(); 
-    return token;
-  case CHAR_LT:
-    ln = lineNo;
-    cn = colNo;
-    readChar();
-    if ((currentChar != EOF) && (charCodes[currentChar] == CHAR_EQ)) {
-      readChar();
-      return makeToken(SB_LE, ln, cn);
-    } else return makeToken(SB_LT, ln, cn);
-  case CHAR_GT:
-    ln = lineNo;
-    cn = colNo;
-    readChar();
-    if ((currentChar != EOF) && (charCodes[currentChar] == CHAR_EQ)) {
-      readChar();
-      return makeToken(SB_GE, ln, cn);
-    } else return makeToken(SB_GT, ln, cn);
-  case CHAR_EQ: 
-    token = makeToken(SB_EQ, lineNo, colNo);
-    readChar(); 
-    return token;
-  case CHAR_EXCLAIMATION:
-    ln = lineNo;
-    cn = colNo;
-    readChar();
-    if ((currentChar != EOF) && (charCodes[currentChar] == CHAR_EQ)) {
-      readChar();
-      return makeToken(SB_NEQ, ln, cn);
-    } else {
-      token = makeToken(TK_NONE, ln, cn);
-      error(ERR_INVALID_SYMBOL, ln, cn);
-      return token;
-    }
-  case CHAR_COMMA:
-    token = makeToken(SB_COMMA, lineNo, colNo);
-    readChar(); 
-    return token;
-  case CHAR_PERIOD:
-    ln = lineNo;
-    cn = colNo;
-    readChar();
-    if ((currentChar != EOF) && (charCodes[currentChar] == CHAR_RPAR)) {
-      readChar();
-      return makeToken(SB_RSEL, ln, cn);
-    } else return makeToken(SB_PERIOD, ln, cn);
-  case CHAR_SEMICOLON:
-    token = makeToken(SB_SEMICOLON, lineNo, colNo);
-    readChar(); 
-    return token;
-  case CHAR_COLON:
-    ln = lineNo;
-    cn = colNo;
-    readChar();
-    if ((currentChar != EOF) && (charCodes[currentChar] == CHAR_EQ)) {
-      readChar();
-      return makeToken(SB_ASSIGN, ln, cn);
-    } else return makeToken(SB_COLON, ln, cn);
-  case CHAR_SINGLEQUOTE: return readConstChar();
-  case CHAR_LPAR:
-    ln = lineNo;
-    cn = colNo;
-    readChar();
-
-    if (currentChar == EOF) 
-      return makeToken(SB_LPAR, ln, cn);
-
-    switch (charCodes[currentChar]) {
-    case CHAR_PERIOD:
-      readChar();
-      return makeToken(SB_LSEL, ln, cn);
-    case CHAR_TIMES:
-      readChar();
-      skipComment();
-      return getToken();
+  setTransition(ST_START, first, ACT_GOTO, state);
+  for (c = 0; c < CHAR_CLASSES; c++)
+    setTransition(state, c, ACT_RETURN, shortToken);
+  setTransition(state, second, ACT_ACCEPT, token);
+}
+
+static void buildScannerTable(void) {
+  int c;
+
+  charClasses[0] = CHAR_EOF;
+  for (c = 0; c < 256; c++)
+    charClasses[c + 1] = charCodes[c];
+
+  for (c = 0; c < CHAR_CLASSES; c++)
+    setTransition(ST_START, c, ACT_ERROR, 0);
+
+  setTransition(ST_START, CHAR_SPACE, ACT_SKIP, 0);
+  setTransition(ST_START, CHAR_LETTER, ACT_IDENT, 0);
+  setTransition(ST_START, CHAR_DIGIT, ACT_NUMBER, 0);
+  setTransition(ST_START, CHAR_SINGLEQUOTE, ACT_CHAR, 0);
+  setTransition(ST_START, CHAR_EOF, ACT_RETURN, TK_EOF);
+
+  setTransition(ST_START, CHAR_PLUS, ACT_ACCEPT, SB_PLUS);
+  setTransition(ST_START, CHAR_MINUS, ACT_ACCEPT, SB_MINUS);
+  setTransition(ST_START, CHAR_TIMES, ACT_ACCEPT, SB_TIMES);
+  setTransition(ST_START, CHAR_SLASH, ACT_ACCEPT, SB_SLASH);
+  setTransition(ST_START, CHAR_EQ, ACT_ACCEPT, SB_EQ);
+  setTransition(ST_START, CHAR_COMMA, ACT_ACCEPT, SB_COMMA);
+  setTransition(ST_START, CHAR_SEMICOLON, ACT_ACCEPT, SB_SEMICOLON);
+  setTransition(ST_START, CHAR_RPAR, ACT_ACCEPT, SB_RPAR);
+
+  addPair(CHAR_LT, ST_LT, CHAR_EQ, SB_LE, SB_LT);
+  addPair(CHAR_GT, ST_GT, CHAR_EQ, SB_GE, SB_GT);
+  addPair(CHAR_PERIOD, ST_PERIOD, CHAR_RPAR, SB_RSEL, SB_PERIOD);
+  addPair(CHAR_COLON, ST_COLON, CHAR_EQ, SB_ASSIGN, SB_COLON);
+  addPair(CHAR_LPAR, ST_LPAR, CHAR_PERIOD, SB_LSEL, SB_LPAR);
+  setTransition(ST_LPAR, CHAR_TIMES, ACT_COMMENT, 0);
+
+  // '!' is only valid as part of "!="
+  addPair(CHAR_EXCLAIMATION, ST_EXCLAIMATION, CHAR_EQ, SB_NEQ, TK_NONE);
+  for (c = 0; c < CHAR_CLASSES; c++)
+    if (c != CHAR_EQ)
+      setTransition(ST_EXCLAIMATION, c, ACT_ERROR, 0);
+}
+
+void initScanner(void) {
+  initKeywords();
+  pthread_once(&scannerOnce, buildScannerTable);
+}
+
+Token* getToken(Compiler* compiler, Token *token) {
+  Reader *reader = &compiler->reader;
+  int state = ST_START;
+  int ln = reader->lineNo, cn = reader->colNo;
+  const Transition *t;
+
+  for (;;) {
+    t = &scannerTable[state][charClasses[reader->currentChar + 1]];
+    switch (t->action) {
+    case ACT_GOTO:
+      readChar(reader);
+      state = t->value;
+      break;
+    case ACT_ACCEPT:
+      readChar(reader);
+      return makeToken(token, t->value, ln, cn);
+    case ACT_RETURN:
+      return makeToken(token, t->value, ln, cn);
+    case ACT_SKIP:
+      skipBlank(reader);
+      ln = reader->lineNo;
+      cn = reader->colNo;
+      break;
+    case ACT_COMMENT:
+      readChar(reader);
+      skipComment(compiler);
+      state = ST_START;
+      ln = reader->lineNo;
+      cn = reader->colNo;
+      break;
+    case ACT_IDENT:
+      return readIdentKeyword(compiler, token);
+    case ACT_NUMBER:
+      return readNumber(compiler, token);
+    case ACT_CHAR:
+      return readConstChar(compiler, token);
     default:
-      return makeToken(SB_LPAR, ln, cn);
+      makeToken(token, TK_NONE, ln, cn);
+      error(compiler, ERR_INVALID_SYMBOL, ln, cn);
+      return token;
     }
-  case CHAR_RPAR:
-    token = makeToken(SB_RPAR, lineNo, colNo);
-    readChar(); 
-    return token;
-  default:
-    token = makeToken(TK_NONE, lineNo, colNo);
-    error(ERR_INVALID_SYMBOL, lineNo, colNo);
-    readChar(); 
-    return token;
   }
 }
 
-Token* getValidToken(void) {
-  Token *token = getToken();
-  while (token->tokenType == TK_NONE) {
-    free(token);
-    token = getToken();
-  }
+Token* getValidToken(Compiler* compiler, Token *token) {
+  while (getToken(compiler, token)->tokenType == TK_NONE)
+    ;
   return token;
 }
 
@@ -7,10 +7,13 @@
 #ifndef __SCANNER_H__
 #define __SCANNER_H__
 
-#include "token.h"
+#include "compiler.h"
 
-Token* getToken(void);
-Token* getValidToken(void);
+// Builds the keyword and DFA tables; call before scanning, any number of times
+void initScanner(void);
+// Both scan the next token into the caller's token and return it
+Token* getToken(Compiler* compiler, Token *token);
+Token* getValidToken(Compiler* compiler, Token *token);
 void printToken(Token *token);
 
 #endif
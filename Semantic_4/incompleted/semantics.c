@@ -9,11 +9,8 @@
 #include "semantics.h"
 #include "error.h"
 
-extern SymTab* symtab;
-extern Token* currentToken;
-
-Object* lookupObject(char *name) {
-  Scope* scope = symtab->currentScope;
+Object* lookupObject(Compiler* compiler, char *name) {
+  Scope* scope = compiler->symtab->currentScope;
   Object* obj;
 
   while (scope != NULL) {
@@ -21,127 +18,127 @@ Object* lookupObject(char *name) {
     if (obj != NULL) return obj;
     scope = scope->outer;
   }
-  obj = findObject(symtab->globalObjectList, name);
+  obj = findObject(compiler->symtab->globalObjectList, name);
   if (obj != NULL) return obj;
   return NULL;
 }
 
-void checkFreshIdent(char *name) {
-  if (findObject(symtab->currentScope->objList, name) != NULL)
-    error(ERR_DUPLICATE_IDENT, currentToken->lineNo, currentToken->colNo);
+void checkFreshIdent(Compiler* compiler, char *name) {
+  if (findObject(compiler->symtab->currentScope->objList, name) != NULL)
+    error(compiler, ERR_DUPLICATE_IDENT, compiler->currentToken->lineNo, compiler->currentToken->colNo);
 }
 
-Object* checkDeclaredIdent(char* name) {
-  Object* obj = lookupObject(name);
+Object* checkDeclaredIdent(Compiler* compiler, char* name) {
+  Object* obj = lookupObject(compiler, name);
   if (obj == NULL) {
-    error(ERR_UNDECLARED_IDENT,currentToken->lineNo, currentToken->colNo);
+    error(compiler, ERR_UNDECLARED_IDENT,compiler->currentToken->lineNo, compiler->currentToken->colNo);
   }
   return obj;
 }
 
-Object* checkDeclaredConstant(char* name) {
-  Object* obj = lookupObject(name);
+Object* checkDeclaredConstant(Compiler* compiler, char* name) {
+  Object* obj = lookupObject(compiler, name);
   if (obj == NULL)
-    error(ERR_UNDECLARED_CONSTANT,currentToken->lineNo, currentToken->colNo);
+    error(compiler, ERR_UNDECLARED_CONSTANT,compiler->currentToken->lineNo, compiler->currentToken->colNo);
   if (obj->kind != OBJ_CONSTANT)
-    error(ERR_INVALID_CONSTANT,currentToken->lineNo, currentToken->colNo);
+    error(compiler, ERR_INVALID_CONSTANT,compiler->currentToken->lineNo, compiler->currentToken->colNo);
 
   return obj;
 }
 
-Object* checkDeclaredType(char* name) {
-  Object* obj = lookupObject(name);
+Object* checkDeclaredType(Compiler* compiler, char* name) {
+  Object* obj = lookupObject(compiler, name);
   if (obj == NULL)
-    error(ERR_UNDECLARED_TYPE,currentToken->lineNo, currentToken->colNo);
+    error(compiler, ERR_UNDECLARED_TYPE,compiler->currentToken->lineNo, compiler->currentToken->colNo);
   if (obj->kind != OBJ_TYPE)
-    error(ERR_INVALID_TYPE,currentToken->lineNo, currentToken->colNo);
+    error(compiler, ERR_INVALID_TYPE,compiler->currentToken->lineNo, compiler->currentToken->colNo);
 
   return obj;
 }
 
-Object* checkDeclaredVariable(char* name) {
-  Object* obj = lookupObject(name);
+Object* checkDeclaredVariable(Compiler* compiler, char* name) {
+  Object* obj = lookupObject(compiler, name);
   if (obj == NULL)
-    error(ERR_UNDECLARED_VARIABLE,currentToken->lineNo, currentToken->colNo);
+    error(compiler, ERR_UNDECLARED_VARIABLE,compiler->currentToken->lineNo, compiler->currentToken->colNo);
   if (obj->kind != OBJ_VARIABLE)
-    error(ERR_INVALID_VARIABLE,currentToken->lineNo, currentToken->colNo);
+    error(compiler, ERR_INVALID_VARIABLE,compiler->currentToken->lineNo, compiler->currentToken->colNo);
 
   return obj;
 }
 
-Object* checkDeclaredFunction(char* name) {
-  Object* obj = lookupObject(name);
+Object* checkDeclaredFunction(Compiler* compiler, char* name) {
+  Object* obj = lookupObject(compiler, name);
   if (obj == NULL)
-    error(ERR_UNDECLARED_FUNCTION,currentToken->lineNo, currentToken->colNo);
+    error(compiler, ERR_UNDECLARED_FUNCTION,compiler->currentToken->lineNo, compiler->currentToken->colNo);
   if (obj->kind != OBJ_FUNCTION)
-    error(ERR_INVALID_FUNCTION,currentToken->lineNo, currentToken->colNo);
+    error(compiler, ERR_INVALID_FUNCTION,compiler->currentToken->lineNo, compiler->currentToken->colNo);
 
   return obj;
 }
 
-Object* checkDeclaredProcedure(char* name) {
-  Object* obj = lookupObject(name);
+Object* checkDeclaredProcedure(Compiler* compiler, char* name) {
+  Object* obj = lookupObject(compiler, name);
   if (obj == NULL)
-    error(ERR_UNDECLARED_PROCEDURE,currentToken->lineNo, currentToken->colNo);
+    error(compiler, ERR_UNDECLARED_PROCEDURE,compiler->currentToken->lineNo, compiler->currentToken->colNo);
   if (obj->kind != OBJ_PROCEDURE)
-    error(ERR_INVALID_PROCEDURE,currentToken->lineNo, currentToken->colNo);
+    error(compiler, ERR_INVALID_PROCEDURE,compiler->currentToken->lineNo, compiler->currentToken->colNo);
 
   return obj;
 }
 
-Object* checkDeclaredLValueIdent(char* name) {
-  Object* obj = lookupObject(name);
+Object* checkDeclaredLValueIdent(Compiler* compiler, char* name) {
+  Object* obj = lookupObject(compiler, name);
   if (obj == NULL)
-    error(ERR_UNDECLARED_IDENT,currentToken->lineNo, currentToken->colNo);
+    error(compiler, ERR_UNDECLARED_IDENT,compiler->currentToken->lineNo, compiler->currentToken->colNo);
 
   switch (obj->kind) {
   case OBJ_VARIABLE:
   case OBJ_PARAMETER:
     break;
   case OBJ_FUNCTION:
-    if (obj != symtab->currentScope->owner) 
-      error(ERR_INVALID_IDENT,currentToken->lineNo, currentToken->colNo);
+    if (obj != compiler->symtab->currentScope->owner) 
+      error(compiler, ERR_INVALID_IDENT,compiler->currentToken->lineNo, compiler->currentToken->colNo);
     break;
   default:
-    error(ERR_INVALID_IDENT,currentToken->lineNo, currentToken->colNo);
+    error(compiler, ERR_INVALID_IDENT,compiler->currentToken->lineNo, compiler->currentToken->colNo);
   }
 
   return obj;
 }
 
 
-void checkIntType(Type* type) {
+void checkIntType(Compiler* compiler, Type* type) {
   if ((type != NULL) && (type->typeClass == TP_INT))
     return;
-  error(ERR_TYPE_INCONSISTENCY, currentToken->lineNo, currentToken->colNo);
+  error(compiler, ERR_TYPE_INCONSISTENCY, compiler->currentToken->lineNo, compiler->currentToken->colNo);
 }
 
-void checkCharType(Type* type) {
+void checkCharType(Compiler* compiler, Type* type) {
   if ((type != NULL) && (type->typeClass == TP_CHAR))
     return;
-  error(ERR_TYPE_INCONSISTENCY, currentToken->lineNo, currentToken->colNo);
+  error(compiler, ERR_TYPE_INCONSISTENCY, compiler->currentToken->lineNo, compiler->currentToken->colNo);
 }
 
-void checkBasicType(Type* type) {
+void checkBasicType(Compiler* compiler, Type* type) {
   if ((type != NULL) && ((type->typeClass == TP_INT) || (type->typeClass == TP_CHAR)))
     return;
-  error(ERR_TYPE_INCONSISTENCY, currentToken->lineNo, currentToken->colNo);
+  error(compiler, ERR_TYPE_INCONSISTENCY, compiler->currentToken->lineNo, compiler->currentToken->colNo);
 }
 
-void checkArrayType(Type* type) {
+void checkArrayType(Compiler* compiler, Type* type) {
   if ((type != NULL) && (type->typeClass == TP_ARRAY))
     return;
-  error(ERR_TYPE_INCONSISTENCY, currentToken->lineNo, currentToken->colNo);
+  error(compiler, ERR_TYPE_INCONSISTENCY, compiler->currentToken->lineNo, compiler->currentToken->colNo);
 }
 
-void checkTypeEquality(Type* type1, Type* type2) {
+void checkTypeEquality(Compiler* compiler, Type* type1, Type* type2) {
   if (type1->typeClass != type2->typeClass) {
-    error(ERR_TYPE_INCONSISTENCY, currentToken->lineNo, currentToken->colNo);
+    error(compiler, ERR_TYPE_INCONSISTENCY, compiler->currentToken->lineNo, compiler->currentToken->colNo);
   } else {
     if (type1->typeClass == TP_ARRAY) {
       if (type1->arraySize != type2->arraySize)
-        error(ERR_TYPE_INCONSISTENCY, currentToken->lineNo, currentToken->colNo);
-      checkTypeEquality(type1->elementType, type2->elementType);
+        error(compiler, ERR_TYPE_INCONSISTENCY, compiler->currentToken->lineNo, compiler->currentToken->colNo);
+      checkTypeEquality(compiler, type1->elementType, type2->elementType);
     }
   }
 }
@@ -7,21 +7,21 @@
 #ifndef __SEMANTICS_H__
 #define __SEMANTICS_H__
 
-#include "symtab.h"
+#include "compiler.h"
 
-void checkFreshIdent(char *name);
-Object* checkDeclaredIdent(char *name);
-Object* checkDeclaredConstant(char *name);
-Object* checkDeclaredType(char *name);
-Object* checkDeclaredVariable(char *name);
-Object* checkDeclaredFunction(char *name);
-Object* checkDeclaredProcedure(char *name);
-Object* checkDeclaredLValueIdent(char *name);
+void checkFreshIdent(Compiler* compiler, char *name);
+Object* checkDeclaredIdent(Compiler* compiler, char *name);
+Object* checkDeclaredConstant(Compiler* compiler, char *name);
+Object* checkDeclaredType(Compiler* compiler, char *name);
+Object* checkDeclaredVariable(Compiler* compiler, char *name);
+Object* checkDeclaredFunction(Compiler* compiler, char *name);
+Object* checkDeclaredProcedure(Compiler* compiler, char *name);
+Object* checkDeclaredLValueIdent(Compiler* compiler, char *name);
 
-void checkIntType(Type* type);
-void checkCharType(Type* type);
-void checkArrayType(Type* type);
-void checkBasicType(Type* type);
-void checkTypeEquality(Type* type1, Type* type2);
+void checkIntType(Compiler* compiler, Type* type);
+void checkCharType(Compiler* compiler, Type* type);
+void checkArrayType(Compiler* compiler, Type* type);
+void checkBasicType(Compiler* compiler, Type* type);
+void checkTypeEquality(Compiler* compiler, Type* type1, Type* type2);
 
 #endif
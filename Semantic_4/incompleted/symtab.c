@@ -10,15 +10,10 @@
 #include "symtab.h"
 #include "error.h"
 
-void freeObject(Object* obj);
 void freeScope(Scope* scope);
 void freeObjectList(ObjectNode *objList);
 void freeReferenceList(ObjectNode *objList);
 
-SymTab* symtab;
-Type* intType;
-Type* charType;
-
 /******************* Type utilities ******************************/
 
 Type* makeIntType(void) {
@@ -62,6 +57,8 @@ int compareType(Type* type1, Type* type2) {
 }
 
 void freeType(Type* type) {
+  // An object abandoned by error() before its type was parsed has none
+  if (type == NULL) return;
   switch (type->typeClass) {
   case TP_INT:
   case TP_CHAR:
@@ -69,7 +66,7 @@ void freeType(Type* type) {
     break;
   case TP_ARRAY:
     freeType(type->elementType);
-    freeType(type);
+    free(type);
     break;
   }
 }
@@ -110,9 +107,9 @@ Scope* createScope(Object* owner, Scope* outer) {
   return scope;
 }
 
-Object* createProgramObject(char *programName) {
+Object* createProgramObject(SymTab* symtab, char *programName) {
   Object* program = (Object*) malloc(sizeof(Object));
-  strcpy(program->name, programName);
+  program->name = programName;
   program->kind = OBJ_PROGRAM;
   program->progAttrs = (ProgramAttributes*) malloc(sizeof(ProgramAttributes));
   program->progAttrs->scope = createScope(program,NULL);
@@ -123,42 +120,46 @@ Object* createProgramObject(char *programName) {
 
 Object* createConstantObject(char *name) {
   Object* obj = (Object*) malloc(sizeof(Object));
-  strcpy(obj->name, name);
+  obj->name = name;
   obj->kind = OBJ_CONSTANT;
   obj->constAttrs = (ConstantAttributes*) malloc(sizeof(ConstantAttributes));
+  obj->constAttrs->value = NULL;
   return obj;
 }
 
 Object* createTypeObject(char *name) {
   Object* obj = (Object*) malloc(sizeof(Object));
-  strcpy(obj->name, name);
+  obj->name = name;
   obj->kind = OBJ_TYPE;
   obj->typeAttrs = (TypeAttributes*) malloc(sizeof(TypeAttributes));
+  obj->typeAttrs->actualType = NULL;
   return obj;
 }
 
-Object* createVariableObject(char *name) {
+Object* createVariableObject(SymTab* symtab, char *name) {
   Object* obj = (Object*) malloc(sizeof(Object));
-  strcpy(obj->name, name);
+  obj->name = name;
   obj->kind = OBJ_VARIABLE;
   obj->varAttrs = (VariableAttributes*) malloc(sizeof(VariableAttributes));
+  obj->varAttrs->type = NULL;
   obj->varAttrs->scope = symtab->currentScope;
   return obj;
 }
 
-Object* createFunctionObject(char *name) {
+Object* createFunctionObject(SymTab* symtab, char *name) {
   Object* obj = (Object*) malloc(sizeof(Object));
-  strcpy(obj->name, name);
+  obj->name = name;
   obj->kind = OBJ_FUNCTION;
   obj->funcAttrs = (FunctionAttributes*) malloc(sizeof(FunctionAttributes));
   obj->funcAttrs->paramList = NULL;
+  obj->funcAttrs->returnType = NULL;
   obj->funcAttrs->scope = createScope(obj, symtab->currentScope);
   return obj;
 }
 
-Object* createProcedureObject(char *name) {
+Object* createProcedureObject(SymTab* symtab, char *name) {
   Object* obj = (Object*) malloc(sizeof(Object));
-  strcpy(obj->name, name);
+  obj->name = name;
   obj->kind = OBJ_PROCEDURE;
   obj->procAttrs = (ProcedureAttributes*) malloc(sizeof(ProcedureAttributes));
   obj->procAttrs->paramList = NULL;
@@ -168,10 +169,11 @@ Object* createProcedureObject(char *name) {
 
 Object* createParameterObject(char *name, enum ParamKind kind, Object* owner) {
   Object* obj = (Object*) malloc(sizeof(Object));
-  strcpy(obj->name, name);
+  obj->name = name;
   obj->kind = OBJ_PARAMETER;
   obj->paramAttrs = (ParameterAttributes*) malloc(sizeof(ParameterAttributes));
   obj->paramAttrs->kind = kind;
+  obj->paramAttrs->type = NULL;
   obj->paramAttrs->function = owner;
   return obj;
 }
@@ -183,11 +185,11 @@ void freeObject(Object* obj) {
     free(obj->constAttrs);
     break;
   case OBJ_TYPE:
-    free(obj->typeAttrs->actualType);
+    freeType(obj->typeAttrs->actualType);
     free(obj->typeAttrs);
     break;
   case OBJ_VARIABLE:
-    free(obj->varAttrs->type);
+    freeType(obj->varAttrs->type);
     free(obj->varAttrs);
     break;
   case OBJ_FUNCTION:
@@ -254,7 +256,7 @@ void addObject(ObjectNode **objList, Object* obj) {
 
 Object* findObject(ObjectNode *objList, char *name) {
   while (objList != NULL) {
-    if (strcmp(objList->object->name, name) == 0) 
+    if (objList->object->name == name) 
       return objList->object;
     else objList = objList->next;
   }
@@ -263,57 +265,64 @@ Object* findObject(ObjectNode *objList, char *name) {
 
 /******************* others ******************************/
 
-void initSymTab(void) {
+SymTab* initSymTab(NameTable* names) {
+  SymTab* symtab;
   Object* obj;
   Object* param;
 
   symtab = (SymTab*) malloc(sizeof(SymTab));
+  symtab->program = NULL;
+  symtab->currentScope = NULL;
   symtab->globalObjectList = NULL;
   
-  obj = createFunctionObject("READC");
+  obj = createFunctionObject(symtab, internName(names, "READC", 5));
   obj->funcAttrs->returnType = makeCharType();
   addObject(&(symtab->globalObjectList), obj);
 
-  obj = createFunctionObject("READI");
+  obj = createFunctionObject(symtab, internName(names, "READI", 5));
   obj->funcAttrs->returnType = makeIntType();
   addObject(&(symtab->globalObjectList), obj);
 
-  obj = createProcedureObject("WRITEI");
-  param = createParameterObject("i", PARAM_VALUE, obj);
+  obj = createProcedureObject(symtab, internName(names, "WRITEI", 6));
+  param = createParameterObject(internName(names, "i", 1), PARAM_VALUE, obj);
   param->paramAttrs->type = makeIntType();
   addObject(&(obj->procAttrs->paramList),param);
+  addObject(&(obj->procAttrs->scope->objList),param);
   addObject(&(symtab->globalObjectList), obj);
 
-  obj = createProcedureObject("WRITEC");
-  param = createParameterObject("ch", PARAM_VALUE, obj);
+  obj = createProcedureObject(symtab, internName(names, "WRITEC", 6));
+  param = createParameterObject(internName(names, "ch", 2), PARAM_VALUE, obj);
   param->paramAttrs->type = makeCharType();
   addObject(&(obj->procAttrs->paramList),param);
+  addObject(&(obj->procAttrs->scope->objList),param);
   addObject(&(symtab->globalObjectList), obj);
 
-  obj = createProcedureObject("WRITELN");
+  obj = createProcedureObject(symtab, internName(names, "WRITELN", 7));
   addObject(&(symtab->globalObjectList), obj);
 
-  intType = makeIntType();
-  charType = makeCharType();
+  symtab->intType = makeIntType();
+  symtab->charType = makeCharType();
+  return symtab;
 }
 
-void cleanSymTab(void) {
-  freeObject(symtab->program);
+void cleanSymTab(SymTab* symtab) {
+  if (symtab->program != NULL)
+    freeObject(symtab->program);
   freeObjectList(symtab->globalObjectList);
+  freeType(symtab->intType);
+  freeType(symtab->charType);
   free(symtab);
-  freeType(intType);
-  freeType(charType);
 }
 
-void enterBlock(Scope* scope) {
+void enterBlock(SymTab* symtab, Scope* scope) {
   symtab->currentScope = scope;
 }
 
-void exitBlock(void) {
+void exitBlock(SymTab* symtab) {
   symtab->currentScope = symtab->currentScope->outer;
 }
 
-void declareObject(Object* obj) {
+void declareObject(SymTab* symtab, Object* obj) {
   if (obj->kind == OBJ_PARAMETER) {
     Object* owner = symtab->currentScope->owner;
     switch (owner->kind) {
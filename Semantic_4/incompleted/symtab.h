@@ -8,6 +8,7 @@
 #define __SYMTAB_H__
 
 #include "token.h"
+#include "names.h"
 
 enum TypeClass {
   TP_INT,
@@ -97,7 +98,7 @@ typedef struct ProgramAttributes_ ProgramAttributes;
 typedef struct ParameterAttributes_ ParameterAttributes;
 
 struct Object_ {
-  char name[MAX_IDENT_LEN];
+  char *name;                         // interned, compare with ==
   enum ObjectKind kind;
   union {
     ConstantAttributes* constAttrs;
@@ -131,6 +132,9 @@ struct SymTab_ {
   Object* program;
   Scope* currentScope;
   ObjectNode *globalObjectList;
+  // Shared types of constants and literals in expressions
+  Type* intType;
+  Type* charType;
 };
 
 typedef struct SymTab_ SymTab;
@@ -148,20 +152,22 @@ ConstantValue* duplicateConstantValue(ConstantValue* v);
 
 Scope* createScope(Object* owner, Scope* outer);
 
-Object* createProgramObject(char *programName);
+Object* createProgramObject(SymTab* symtab, char *programName);
 Object* createConstantObject(char *name);
 Object* createTypeObject(char *name);
-Object* createVariableObject(char *name);
-Object* createFunctionObject(char *name);
-Object* createProcedureObject(char *name);
+Object* createVariableObject(SymTab* symtab, char *name);
+Object* createFunctionObject(SymTab* symtab, char *name);
+Object* createProcedureObject(SymTab* symtab, char *name);
 Object* createParameterObject(char *name, enum ParamKind kind, Object* owner);
+void freeObject(Object* obj);
 
+// name must be interned in the same table as the objects' names
 Object* findObject(ObjectNode *objList, char *name);
 
-void initSymTab(void);
-void cleanSymTab(void);
-void enterBlock(Scope* scope);
-void exitBlock(void);
-void declareObject(Object* obj);
+SymTab* initSymTab(NameTable* names);
+void cleanSymTab(SymTab* symtab);
+void enterBlock(SymTab* symtab, Scope* scope);
+void exitBlock(SymTab* symtab);
+void declareObject(SymTab* symtab, Object* obj);
 
 #endif
@@ -4,10 +4,17 @@
  * @version 1.0
  */
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <string.h>
+#include <pthread.h>
 #include "token.h"
 
+#define KEYWORD_SLOTS 64
+// Collision-free for the keywords below; buildKeywordTable() rejects a new keyword that collides
+#define KEYWORD_HASH(length, first, last) (((length) + 2 * (first) + (last)) & (KEYWORD_SLOTS - 1))
+
 struct {
   char string[MAX_IDENT_LEN + 1];
   TokenType tokenType;
@@ -42,17 +49,43 @@ int keywordEq(char *kw, char *string) {
   return ((*kw == '\0') && (*string == '\0'));
 }
 
-TokenType checkKeyword(char *string) {
-  int i;
-  for (i = 0; i < KEYWORDS_COUNT; i++)
-    if (keywordEq(keywords[i].string, string)) 
-      return keywords[i].tokenType;
+// Index into keywords[] of the only keyword that can have a given hash, -1 if none
+static signed char keywordSlots[KEYWORD_SLOTS];
+static pthread_once_t keywordsOnce = PTHREAD_ONCE_INIT;
+
+static int keywordHash(const char *string, int length) {
+  return KEYWORD_HASH(length, (unsigned char) string[0], (unsigned char) string[length - 1]);
+}
+
+static void buildKeywordTable(void) {
+  int i, slot;
+
+  memset(keywordSlots, -1, sizeof(keywordSlots));
+  for (i = 0; i < KEYWORDS_COUNT; i++) {
+    slot = keywordHash(keywords[i].string, strlen(keywords[i].string));
+    if (keywordSlots[slot] >= 0) {
+      fprintf(stderr, "Keywords %s and %s collide, change KEYWORD_HASH.\n",
+              keywords[keywordSlots[slot]].string, keywords[i].string);
+      exit(-1);
+    }
+    keywordSlots[slot] = i;
+  }
+}
+
+void initKeywords(void) {
+  pthread_once(&keywordsOnce, buildKeywordTable);
+}
+
+TokenType checkKeyword(char *string, int length) {
+  int i = keywordSlots[keywordHash(string, length)];
+  if ((i >= 0) && keywordEq(keywords[i].string, string))
+    return keywords[i].tokenType;
   return TK_NONE;
 }
 
-Token* makeToken(TokenType tokenType, int lineNo, int colNo) {
-  Token *token = (Token*)malloc(sizeof(Token));
+Token* makeToken(Token *token, TokenType tokenType, int lineNo, int colNo) {
   token->tokenType = tokenType;
+  token->name = NULL;
   token->lineNo = lineNo;
   token->colNo = colNo;
   return token;
@@ -28,13 +28,16 @@ typedef enum {
 
 typedef struct {
   char string[MAX_IDENT_LEN + 1];
+  char *name;                         // interned identifier, TK_IDENT only
   int lineNo, colNo;
   TokenType tokenType;
   int value;
 } Token;
 
-TokenType checkKeyword(char *string);
-Token* makeToken(TokenType tokenType, int lineNo, int colNo);
+// Builds the keyword hash table; call before checkKeyword(), any number of times
+void initKeywords(void);
+TokenType checkKeyword(char *string, int length);
+Token* makeToken(Token *token, TokenType tokenType, int lineNo, int colNo);
 char *tokenToString(TokenType tokenType);
 
 